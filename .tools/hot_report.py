@@ -0,0 +1,118 @@
+#!/usr/bin/env python3
+"""
+List the hot path routines (functions marked with HOT, see compiler.h) and
+their placement in the final image. Takes the output of 'nm -n -S' and the
+list of the source files that are scanned for the HOT annotations.
+
+usage: hot_report.py <file.nms> <source.c> [source.c ...]
+
+Functions that were annotated but ended up in flash (or got inlined and thus
+have no symbol) are reported, as well as the flash-ram call veneers generated
+by the linker (every call through the veneer costs few extra cycles).
+"""
+
+import argparse
+import re
+import sys
+
+# nm -n -S line: '<address> [<size>] <type> <name>'
+NM_RE = re.compile(r'^([0-9a-fA-F]{8})(?: ([0-9a-fA-F]{8}))? (\w) (\S+)\s*$')
+# HOT annotation and the identifiers followed by '(' (function name or the
+# attribute macros like OPTIMIZE("Os") or __attribute__ that are skipped)
+HOT_RE = re.compile(r'\bHOT\b')
+CALL_RE = re.compile(r'(\w+)\s*\(')
+
+
+class Symbols:
+    """ symbols read from the nm output """
+
+    def __init__(self, path):
+        self.syms, self.by_name = [], {}
+        with open(path) as f:
+            for line in f:
+                m = NM_RE.match(line)
+                if not m:
+                    continue
+                addr, size = int(m.group(1), 16), int(m.group(2) or '0', 16)
+                sym = (addr, size, m.group(3), m.group(4))
+                self.syms.append(sym)
+                self.by_name.setdefault(m.group(4), sym)
+
+    def addr(self, name):
+        """ address of the linker defined symbol """
+        sym = self.by_name.get(name)
+        return sym[0] if sym else None
+
+
+def region(addr):
+    """ memory region name for given address """
+    if 0x08000000 <= addr < 0x10000000:
+        return 'FLASH'
+    if 0x20000000 <= addr < 0x40000000:
+        return 'RAM'
+    return '?'
+
+
+def hot_functions(sources):
+    """ yield (source, function name) for every HOT annotation """
+    for src in sources:
+        try:
+            with open(src) as f:
+                text = f.read()
+        except OSError:
+            continue
+        for m in HOT_RE.finditer(text):
+            for c in CALL_RE.finditer(text, m.end(), m.end() + 256):
+                if not c.group(1).isupper() and \
+                        not c.group(1).startswith('__'):
+                    yield src, c.group(1)
+                    break
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__,
+        formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument('nms', help='output of nm -n -S')
+    ap.add_argument('sources', nargs='+', help='source files to scan')
+    args = ap.parse_args()
+
+    syms = Symbols(args.nms)
+    hot_addr = syms.addr('__hot_code_addr')
+    hot_size = syms.addr('__hot_code_size')
+    ram_size = syms.addr('__ram_code_size')
+    if hot_addr is None:
+        sys.exit('no __hot_code_addr symbol, is the linker script up to date?')
+
+    print('ram code: %d bytes, hot code: %d bytes at 0x%08x' % (
+        ram_size or 0, hot_size or 0, hot_addr))
+    print('%-32s %-6s %-10s %6s  %s' % ('function', 'where', 'address',
+        'size', 'source'))
+
+    misplaced = 0
+    for src, name in sorted(set(hot_functions(args.sources)),
+            key=lambda x: x[1]):
+        sym = syms.by_name.get(name)
+        if sym is None:
+            print('%-32s %-6s %-10s %6s  %s' % (name, '-', 'missing', '-',
+                src))
+            misplaced += 1
+            continue
+        addr, size, _, _ = sym
+        where = region(addr)
+        misplaced += where != 'RAM'
+        print('%-32s %-6s 0x%08x %6d  %s' % (name, where, addr & ~1, size,
+            src))
+
+    # veneers are generated for the calls that do not reach the destination
+    veneers = [s for s in syms.syms if s[3].endswith('_veneer')]
+    print('%d veneers' % len(veneers))
+    for addr, _, _, name in veneers:
+        print('  %-30s %-6s 0x%08x' % (name, region(addr), addr & ~1))
+
+    if misplaced:
+        print('%d hot function(s) not in ram' % misplaced)
+        sys.exit(1)
+
+
+if __name__ == '__main__':
+    main()
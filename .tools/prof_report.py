@@ -0,0 +1,116 @@
+#!/usr/bin/env python3
+"""
+Resolve the statistical profiler dump (see dev/prof.h) against the symbol
+file generated by the Makefile (nm -n -o) and print the flat profile.
+
+usage: prof_report.py <file.sym> [dump.log] [--all] [--top N] [--callers N]
+
+The dump is searched for within the log (debug output) so it may contain any
+other messages. By default the last complete dump is used, --all sums all of
+them. The link register that was sampled along with the program counter is
+used to show who called the hottest functions (accurate for leaf functions
+like memcpy or checksum routines).
+"""
+
+import argparse
+import bisect
+import collections
+import re
+import sys
+
+# symbol file line: '<file>:<address> <type> <name>'
+SYM_RE = re.compile(r'([0-9a-fA-F]{8}) ([tTwW]) (\S+)\s*$')
+# dump lines
+BEGIN_RE = re.compile(r'prof: begin period_us=(\d+) samples=(\d+) '
+    r'dropped=(\d+)')
+ENTRY_RE = re.compile(r'prof: ([0-9a-fA-F]{8}) ([0-9a-fA-F]{8}) (\d+)')
+END_RE = re.compile(r'prof: end')
+
+
+class Symbols:
+    """ code symbols sorted by the address """
+
+    def __init__(self, path):
+        syms = {}
+        with open(path) as f:
+            for line in f:
+                m = SYM_RE.search(line)
+                if m:
+                    # thumb functions may have the lowest bit set
+                    syms.setdefault(int(m.group(1), 16) & ~1, m.group(3))
+        self.addrs = sorted(syms)
+        self.names = [syms[a] for a in self.addrs]
+
+    def resolve(self, addr):
+        """ return the name of the function that contains the address """
+        i = bisect.bisect_right(self.addrs, addr) - 1
+        return self.names[i] if i >= 0 else '0x%08x' % addr
+
+
+def parse_dumps(f):
+    """ yield (header, entries) for every complete dump found in the log """
+    header, entries = None, None
+    for line in f:
+        m = BEGIN_RE.search(line)
+        if m:
+            header, entries = tuple(int(x) for x in m.groups()), []
+            continue
+        if entries is None:
+            continue
+        m = ENTRY_RE.search(line)
+        if m:
+            entries.append((int(m.group(1), 16), int(m.group(2), 16),
+                int(m.group(3))))
+        elif END_RE.search(line):
+            yield header, entries
+            header, entries = None, None
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__,
+        formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument('sym', help='symbol file')
+    ap.add_argument('dump', nargs='?', help='log with the dump (stdin if '
+        'omitted)')
+    ap.add_argument('--all', action='store_true', help='sum all the dumps')
+    ap.add_argument('--top', type=int, default=30, help='number of functions '
+        'to show')
+    ap.add_argument('--callers', type=int, default=3, help='number of callers '
+        'to show per function')
+    args = ap.parse_args()
+
+    syms = Symbols(args.sym)
+    with (open(args.dump) if args.dump else sys.stdin) as f:
+        dumps = list(parse_dumps(f))
+    if not dumps:
+        sys.exit('no complete profiler dump found')
+    if not args.all:
+        dumps = dumps[-1:]
+
+    # aggregate samples per function and per caller
+    flat = collections.Counter()
+    callers = collections.defaultdict(collections.Counter)
+    period, samples, dropped = dumps[-1][0][0], 0, 0
+    for (_, s, d), entries in dumps:
+        samples, dropped = samples + s, dropped + d
+        for pc, lr, count in entries:
+            func = syms.resolve(pc)
+            flat[func] += count
+            callers[func][syms.resolve(lr)] += count
+
+    total = sum(flat.values()) or 1
+    print('%d samples (%.1f s at %d us), %d dropped' % (samples,
+        samples * period / 1e6, period, dropped))
+    print('%7s %7s %8s  %s' % ('self%', 'cum%', 'samples', 'function'))
+    cum = 0
+    for func, count in flat.most_common(args.top):
+        cum += count
+        print('%6.2f%% %6.2f%% %8d  %s' % (100 * count / total,
+            100 * cum / total, count, func))
+        for caller, ccount in callers[func].most_common(args.callers):
+            if caller != func:
+                print('%25s <- %s (%d)' % ('', caller, ccount))
+
+
+if __name__ == '__main__':
+    main()
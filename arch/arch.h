@@ -97,6 +97,16 @@ static inline ALWAYS_INLINE void Arch_DSB(void)
     ASM volatile ("dsb \n");
 }
 
+/**
+ * @brief The DMB instruction ensures that all explicit memory accesses before
+ * it are observed before any explicit memory accesses after it.
+ */
+static inline ALWAYS_INLINE void Arch_DMB(void)
+{
+    /* order memory accesses */
+    ASM volatile ("dmb \n" : : : "memory");
+}
+
 /**
  * @brief It flushes the pipeline of the processor, so that all instructions
  * following the ISB are fetched from cache or memory again, after the ISB
@@ -48,6 +48,10 @@
 /* additional helpers/shorthands, used has to go here otherwise the optimizer may
  * clear out the function call, thus removing it from section */
 #define RAM_CODE                NOINLINE SECTION(".ram_code")
+/* hot path routines: executed from ram (no flash wait states) and optimized
+ * for speed. list these with 'make hot_report' */
+#define HOT                     NOINLINE SECTION(".hot_code")             \
+                                __attribute__ ((hot))
 
 #endif /* COMPILER_H_ */
 
@@ -22,7 +22,7 @@
 #endif
 
 
-/** System Clock configuration */
+/** System Clock configuration (maximal values, see CpuClock_SetLevel()) */
 /** mcu frequency */
 #define CPUCLOCK_HZ                                 84000000
 /** ahb frequency */
@@ -33,6 +33,22 @@
 #define APB2CLOCK_HZ                                (CPUCLOCK_HZ / 1)
 
 
+/** Clock governor configuration */
+/** scale the clock down when the system is idle */
+#define CPUCLOCK_GOVERNOR_ENABLED                   1
+/** load sampling period in ms */
+#define CPUCLOCK_GOVERNOR_PERIOD                    100
+/** maximal number of clock change callbacks */
+#define CPUCLOCK_MAX_CBS                            8
+/** load (in permille) above which the clock goes straight to the maximum */
+#define GOVERNOR_UP_PERMILLE                        800
+/** clock is lowered when the load predicted for the lower clock stays below
+ * this level (in permille) for GOVERNOR_DOWN_PERIODS */
+#define GOVERNOR_TARGET_PERMILLE                    600
+/** number of consecutive periods required to lower the clock */
+#define GOVERNOR_DOWN_PERIODS                       5
+
+
 /** Debug configuration */
 /** default debug level  */
 #define DEBUG_DEFAULT_LEVEL                         DLVL_WARN
@@ -82,20 +98,68 @@
 #define DMA_SPI1_RX_CHANNEL                         DMA2_S0_SPI1_RX
 
 
+/** System configuration block (see sysconf.h), pool sizes marked as
+ * defaults are used when there is no valid configuration stored in flash */
+/** size of the main stack (used by init and the interrupts) that is placed at
+ * the top of the ram, everything between static data and it can be heap */
+#define SYSCONF_MSP_STACK_SIZE                      2048
+/** heap space that needs to remain free after the pools are accounted for
+ * (task stacks, socket queues, etc..) */
+#define SYSCONF_HEAP_RESERVE                        (16 * 1024)
+
+
 /** Yield configuration */
-/** Memory for the tasks */
-#define SYS_HEAP_SIZE                               (36 * 1024)
-/** coroutine stack size */
+/** Memory for the tasks (default) */
+#define SYS_HEAP_SIZE                               (42 * 1024)
+/** coroutine stack size (default) */
 #define SYS_CORO_STACK_SIZE                         256
-/** maximal number of concurrently running coroutines */
+/** maximal number of concurrently running coroutines (default) */
 #define SYS_CORO_MAX_NUM                            4
 /** sys max event callback subscribers */
 #define SYS_EV_MAX_CBS                              8
+/** sys max number of tasks listening to a single event */
+#define SYS_EV_MAX_LISTENERS                        4
+/** number of events that can be pending for a single listener (power of 2) */
+#define SYS_EV_LISTENER_QUEUE_SIZE                  4
+/** maximal size of the event argument that is copied into the mailboxes */
+#define SYS_EV_ARG_SIZE                             (4 * sizeof(void *))
+/** maximal number of concurrently running software timers */
+#define SYS_TIMER_MAX_NUM                           32
+/** software timer task stack size */
+#define SYS_TIMER_STACK_SIZE                        1024
+/** time slices longer than that (in cpu cycles) are accounted as busy in the
+ * load statistics, shorter ones are tasks that just poll their conditions */
+#define SYS_YIELD_BUSY_SLICE_CYCLES                 2000
+
+
+/** Profiler configuration */
+/** sample the program counter and dump the profile periodically */
+#define PROF_ENABLED                                0
+/** sampling period in us (odd number to avoid aliasing with periodic tasks) */
+#define PROF_SAMPLING_PERIOD_US                     997
+/** number of (pc, lr) entries in the histogram, must be a power of 2 */
+#define PROF_HIST_SIZE                              512
+/** profile dump interval in ms */
+#define PROF_DUMP_INTERVAL                          10000
+
+
+/** Benchmark configuration */
+/** run the benchmarks on startup and stream the results over usb serial
+ * (set by the build: make BENCH=1, benchmark sources are only linked then) */
+#ifndef BENCH_ENABLED
+#define BENCH_ENABLED                               0
+#endif
+/** number of warm-up iterations before the measurement */
+#define BENCH_WARMUP                                8
+/** number of measured iterations */
+#define BENCH_ITERATIONS                            64
 
 
 /** Interrupt priorities */
 /** systick overflow */
 #define INT_PRI_SYSTICK                             0x00
+/** profiler sampling timer (shall preempt other interrupts) */
+#define INT_PRI_PROF                                0x00
 /** context switcher */
 #define INT_PRI_YIELD                               0xf0
 
@@ -137,15 +201,13 @@
 /** USBEEM Configuration */
 /* maximal size of the ethernet frame */
 #define USBEEM_MAX_ETH_FRAME_LEN                    1518
-/* size of rx buffer expressed in number of ethernet frames */
+/* size of rx buffer expressed in number of usb transfers (default, power
+ * of 2), frames are processed in place so a new transfer can take place while
+ * the previous ones are still being processed */
 #define USBEEM_RX_BUF_CAPACITY                      2
-/* size of tx buffer expressed in number of ethernet frames */
-#define USBEEM_TX_BUF_CAPACITY                      2
-
-
-/** TCP/IP Stack configuration: Rx/Tx */
-/* reception buffer size - must facilitate one full ethernet frame */
-#define TCPIP_RXTX_BUF_SIZE                         1528
+/* size of tx buffer expressed in number of ethernet frames (default, power
+ * of 2), frames are built directly within these buffers */
+#define USBEEM_TX_BUF_CAPACITY                      4
 
 
 /** TCP/IP Stack configuration: Ethetnet */
@@ -175,10 +237,37 @@
 
 
 /** TCP/IP Stack configuration: TCP */
-#define TCPIP_TCP_SOCK_NUM                          4
+/* number of sockets (default), incoming segments are matched against
+ * sockets with hashed lookup so the count does not affect the per-frame
+ * cost */
+#define TCPIP_TCP_SOCK_NUM                          24
+/* initial retransmission timeout in ms (used until the round trip time gets
+ * measured) */
+#define TCPIP_TCP_RTO                               300
+/* retransmission timeout limits in ms, lower limit shall cover the delayed
+ * acks of the remote site */
+#define TCPIP_TCP_RTO_MIN                           50
+#define TCPIP_TCP_RTO_MAX                           8000
+/* number of transmissions of syn or fin after which the connection setup or
+ * teardown is abandoned */
+#define TCPIP_TCP_RETR_MAX                          4
+/* time in ms that we wait for the remote site to close it's side of the
+ * connection after our fin got acked */
+#define TCPIP_TCP_FIN_WAIT_TIMEOUT                  2000
+/* acks for the data received in sequence are delayed by up to this many ms
+ * or until that many segments are received */
+#define TCPIP_TCP_ACK_DELAY                         40
+#define TCPIP_TCP_ACK_SEGS                          2
+/* maximal segment size that we advertise (rx/tx buffer size minus the
+ * ethernet, ip and tcp headers) */
+#define TCPIP_TCP_MSS                               1460
+/* number of sequence ranges received out of order that are kept per socket
+ * (data itself is stored within the rx queue) */
+#define TCPIP_TCP_OOO_NUM                           4
 
 /** TCP/IP Stack configuration: UDP */
-#define TCPIP_UDP_SOCK_NUM                          4
+/* number of sockets (default) */
+#define TCPIP_UDP_SOCK_NUM                          16
 
 
 
@@ -209,6 +298,9 @@
 /**  HTTPSrv configuration */
 /* maximal line length in the http request */
 #define UHTTPSRV_MAX_LINE_LEN                       256
+/* number of connections that may wait for the serving task on top of the
+ * ones being served */
+#define UHTTPSRV_BACKLOG                            4
 
 
 /**  Websocket configuration */
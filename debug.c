@@ -64,7 +64,7 @@ err_t Debug_SetGlobalLevel(int lvl)
 err_t Debug_Send(const void *ptr, size_t size)
 {
     /* send over uart */
-    USART_Send(&usart1, debug_buf, debug_buf_len, 0);
+    USART_Send(&usart1, ptr, size, 0);
 
     /* report status */
     return EOK;
@@ -10,8 +10,30 @@
 #ifndef DEV_CPUCLOCK_H
 #define DEV_CPUCLOCK_H
 
+#include <stdint.h>
+
 #include "err.h"
 
+/** clock levels: the pll stays at 84MHz (so that usb keeps its 48MHz), ahb
+ * prescaler is used to halve the clock with every level. apb1 always runs at
+ * half of the ahb clock, apb2 runs at the ahb clock */
+typedef enum cpuclock_level {
+    CPUCLOCK_LEVEL_84M,
+    CPUCLOCK_LEVEL_42M,
+    CPUCLOCK_LEVEL_21M,
+    /* number of levels */
+    CPUCLOCK_LEVEL_NUM,
+} cpuclock_level_t;
+
+/** clock change callback, called with interrupts disabled right after the
+ * clock has changed so that the drivers can recompute the dividers */
+typedef void (* cpuclock_cb_t)(void);
+
+/** busy callback, called with interrupts disabled right before the clock
+ * changes, returns non-zero if the driver has a transfer in progress that
+ * would get corrupted by the switch */
+typedef int (* cpuclock_busy_cb_t)(void);
+
 /**
  * @brief initialize cpu clock to 256MHz (HSE + PLL). On the
  * nucleo board make sure that you have the solder jumpers set to correct
@@ -21,4 +43,72 @@
  */
 err_t CpuClock_Init(void);
 
+/**
+ * @brief register the callback that is called every time the clock changes
+ *
+ * @param cb callback
+ *
+ * @return err_t EOK or EBUSY if there is no space left for the callback
+ */
+err_t CpuClock_RegisterCallback(cpuclock_cb_t cb);
+
+/**
+ * @brief register the callback that is asked before every clock change
+ * whether the switch can take place now
+ *
+ * @param cb callback
+ *
+ * @return err_t EOK or EBUSY if there is no space left for the callback
+ */
+err_t CpuClock_RegisterBusyCallback(cpuclock_busy_cb_t cb);
+
+/**
+ * @brief switch the clock level. Callbacks are invoked after the switch.
+ * Switch does not take place if any of the busy callbacks reports that the
+ * driver is in the middle of the transfer.
+ *
+ * @param level clock level
+ *
+ * @return err_t EOK, EARGVAL for invalid level or EBUSY if the switch was
+ * refused and needs to be retried later
+ */
+err_t CpuClock_SetLevel(cpuclock_level_t level);
+
+/**
+ * @brief returns current clock level
+ *
+ * @return cpuclock_level_t current level
+ */
+cpuclock_level_t CpuClock_GetLevel(void);
+
+/**
+ * @brief returns current ahb (core) clock frequency
+ *
+ * @return uint32_t frequency in Hz
+ */
+uint32_t CpuClock_GetAHBHz(void);
+
+/**
+ * @brief returns current apb1 bus clock frequency
+ *
+ * @return uint32_t frequency in Hz
+ */
+uint32_t CpuClock_GetAPB1Hz(void);
+
+/**
+ * @brief returns current apb2 bus clock frequency
+ *
+ * @return uint32_t frequency in Hz
+ */
+uint32_t CpuClock_GetAPB2Hz(void);
+
+/**
+ * @brief start the clock governor: the load is sampled from the scheduler
+ * every CPUCLOCK_GOVERNOR_PERIOD and the clock level is adjusted according
+ * to the policy from sys/governor.h
+ *
+ * @return err_t error code
+ */
+err_t CpuClock_GovernorInit(void);
+
 #endif /* DEV_CPUCLOCK_H */
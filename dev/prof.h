@@ -0,0 +1,58 @@
+/**
+ * @file prof.h
+ *
+ * @author Tomasz Watorowski (tomasz.watorowski@gmail.com)
+ * @date 2025-04-18
+ *
+ * @brief Statistical profiler: periodically samples the program counter (and
+ * the link register) of the interrupted code into the histogram. The dump is
+ * resolved against the symbol file by .tools/prof_report.py
+ *
+ * Dump format (one line per entry, embedded in the debug output):
+ *  prof: begin period_us=<us> samples=<n> dropped=<n> entries=<n>
+ *  prof: <pc hex> <lr hex> <count>
+ *  prof: end
+ */
+
+#ifndef DEV_PROF_H
+#define DEV_PROF_H
+
+#include <stdint.h>
+
+#include "err.h"
+
+/** @brief timer interrupt routine that takes the samples */
+void Prof_TIM3Isr(void);
+
+/**
+ * @brief initialize the profiler, requires the free running TIM3 set up by
+ * SysTime_Init(). Starts the dumping task if PROF_ENABLED is set.
+ *
+ * @return err_t error code
+ */
+err_t Prof_Init(void);
+
+/**
+ * @brief start sampling
+ */
+void Prof_Start(void);
+
+/**
+ * @brief stop sampling
+ */
+void Prof_Stop(void);
+
+/**
+ * @brief clear the histogram
+ */
+void Prof_Reset(void);
+
+/**
+ * @brief print the histogram to the debug output. Sampling is paused for the
+ * time of the dump.
+ *
+ * @return err_t error code
+ */
+err_t Prof_Dump(void);
+
+#endif /* DEV_PROF_H */
@@ -18,12 +18,10 @@
 #include "stm32f401/spi.h"
 #include "sys/sem.h"
 
-/** sanitize the clock settings  */
-#if (APB1CLOCK_HZ != 42000000) || (APB2CLOCK_HZ != 84000000)
-    #error "please update the speed enum to match new clock settings"
-#endif
-
-/** spi speeds */
+/** spi speeds (encoded as the prescaler for the apb1 running at the maximal
+ * speed). actual prescaler is computed from the current bus clock so that the
+ * transfer is never faster than requested (clock level is not changed while
+ * the transfer is in progress) */
 typedef enum spi_speed {
     SPI_SPEED_21M = 0,
     SPI_SPEED_10M5 = (SPI_CR1_BR_0),
@@ -9,19 +9,99 @@
 
 #include "config.h"
 #include "err.h"
+#include "dev/cpuclock.h"
 #include "stm32f401/rcc.h"
 #include "stm32f401/flash.h"
 #include "stm32f401/pwr.h"
 #include "stm32f401/scb.h"
 #include "sys/critical.h"
+#include "sys/governor.h"
+#include "sys/timer.h"
+#include "sys/yield.h"
+#include "util/elems.h"
 #include "util/msblsb.h"
 
+#define DEBUG DLVL_INFO
+#include "debug.h"
 
 /** sanitize the clock settings  */
 #if (APB1CLOCK_HZ != 42000000) || (APB2CLOCK_HZ != 84000000)
-    #error "please update the speed enum to match new clock settings"
+    #error "please update the level table to match new clock settings"
 #endif
 
+/* frequency of the internal oscillator that we run from after the reset */
+#define HSI_HZ                                  16000000
+
+/* clock level settings */
+static const struct {
+    /* ahb prescaler and flash wait states */
+    uint32_t hpre, latency;
+} levels[CPUCLOCK_LEVEL_NUM] = {
+    [CPUCLOCK_LEVEL_84M] = { RCC_CFGR_HPRE_DIV1, FLASH_ACR_LATENCY_2WS },
+    [CPUCLOCK_LEVEL_42M] = { RCC_CFGR_HPRE_DIV2, FLASH_ACR_LATENCY_1WS },
+    [CPUCLOCK_LEVEL_21M] = { RCC_CFGR_HPRE_DIV4, FLASH_ACR_LATENCY_0WS },
+};
+
+/* current level, ahb frequency and apb1 prescaler (values after the reset) */
+static cpuclock_level_t level; static uint32_t ahb_hz = HSI_HZ, apb1_div = 1;
+/* clock change callbacks */
+static cpuclock_cb_t cbs[CPUCLOCK_MAX_CBS]; static int cbs_num;
+/* callbacks that may hold the clock change off */
+static cpuclock_busy_cb_t busy_cbs[CPUCLOCK_MAX_CBS]; static int busy_cbs_num;
+
+/* governor state and the timer that drives it */
+static governor_t governor; static systimer_t governor_timer;
+
+/* program the flash latency */
+static void CpuClock_SetLatency(uint32_t latency)
+{
+    /* program the number of wait states */
+    FLASH->ACR = (FLASH->ACR & ~FLASH_ACR_LATENCY) | latency;
+    /* wait for the option to be applied */
+    while ((FLASH->ACR & FLASH_ACR_LATENCY) != latency);
+}
+
+/* call all the clock change callbacks */
+static void CpuClock_CallCallbacks(void)
+{
+    /* let the drivers know */
+    for (int i = 0; i < cbs_num; i++)
+        cbs[i]();
+}
+
+/* check if any of the drivers is in the middle of the transfer */
+static int CpuClock_IsBusy(void)
+{
+    /* ask the drivers */
+    for (int i = 0; i < busy_cbs_num; i++)
+        if (busy_cbs[i]())
+            return 1;
+    /* switch can take place */
+    return 0;
+}
+
+/* sample the load and let the policy decide on the clock level */
+static void CpuClock_GovernorCallback(void *arg)
+{
+    /* load counters */
+    uint32_t busy, total; Yield_ReadLoad(&busy, &total);
+    /* ask the policy */
+    cpuclock_level_t next = Governor_Decide(&governor, busy, total);
+
+    /* nothing to do */
+    if (next == level)
+        return;
+
+    /* drivers are busy: stay where we are, decision will be made again
+     * during the next period */
+    cpuclock_level_t prev = level;
+    if (CpuClock_SetLevel(next) != EOK) {
+        governor.level = level; return;
+    }
+    /* log after the switch so that the message does not get garbled */
+    dprintf_i("clock level %d -> %d, load %d/%d\n", prev, next, busy, total);
+}
+
 /* prepare cpu clock for operation */
 err_t CpuClock_Init(void)
 {
@@ -53,18 +133,119 @@ err_t CpuClock_Init(void)
     RCC->CFGR = RCC_CFGR_PPRE1_DIV2 | RCC_CFGR_HPRE_DIV1 | RCC_CFGR_PPRE2_DIV1;
 
     /* program the number of wait states */
-    FLASH->ACR = FLASH_ACR_LATENCY_2WS;
-    /* wait for the option to be applied */
-    while ((FLASH->ACR & FLASH_ACR_LATENCY) != FLASH_ACR_LATENCY_2WS);
+    CpuClock_SetLatency(FLASH_ACR_LATENCY_2WS);
 
     /* and finally switch the clock */
     RCC->CFGR = (RCC->CFGR & ~RCC_CFGR_SW) | RCC_CFGR_SW_PLL;
     /* wait for the switch to occur */
     while ((RCC->CFGR & RCC_CFGR_SWS) != RCC_CFGR_SWS_PLL);
 
+    /* we are now running at full speed */
+    level = CPUCLOCK_LEVEL_84M, ahb_hz = AHBCLOCK_HZ, apb1_div = 2;
+    /* modules that were initialized before need to adjust */
+    CpuClock_CallCallbacks();
 
     /* exit critical section */
     Critical_Exit();
     /* report status */
     return EOK;
-}
\ No newline at end of file
+}
+
+/* register clock change callback */
+err_t CpuClock_RegisterCallback(cpuclock_cb_t cb)
+{
+    /* no more space */
+    if (cbs_num == elems(cbs))
+        return EBUSY;
+    /* store the callback */
+    cbs[cbs_num++] = cb;
+    /* report status */
+    return EOK;
+}
+
+/* register busy callback */
+err_t CpuClock_RegisterBusyCallback(cpuclock_busy_cb_t cb)
+{
+    /* no more space */
+    if (busy_cbs_num == elems(busy_cbs))
+        return EBUSY;
+    /* store the callback */
+    busy_cbs[busy_cbs_num++] = cb;
+    /* report status */
+    return EOK;
+}
+
+/* switch the clock level */
+err_t CpuClock_SetLevel(cpuclock_level_t new_level)
+{
+    /* sanity check */
+    if (new_level < 0 || new_level >= CPUCLOCK_LEVEL_NUM)
+        return EARGVAL;
+    /* nothing to do */
+    if (new_level == level)
+        return EOK;
+
+    /* enter critical section */
+    Critical_Enter();
+
+    /* changing the clock in the middle of the transfer would corrupt it */
+    if (CpuClock_IsBusy()) {
+        Critical_Exit(); return EBUSY;
+    }
+
+    /* going up: wait states need to be increased before the switch */
+    if (new_level < level)
+        CpuClock_SetLatency(levels[new_level].latency);
+    /* change the ahb prescaler, pll (and usb clock) stays intact */
+    RCC->CFGR = (RCC->CFGR & ~RCC_CFGR_HPRE) | levels[new_level].hpre;
+    /* going down: wait states can be decreased after the switch */
+    if (new_level > level)
+        CpuClock_SetLatency(levels[new_level].latency);
+
+    /* store the new settings */
+    level = new_level, ahb_hz = AHBCLOCK_HZ >> new_level;
+    /* let the drivers recompute their dividers */
+    CpuClock_CallCallbacks();
+
+    /* exit critical section */
+    Critical_Exit();
+    /* report status */
+    return EOK;
+}
+
+/* returns current clock level */
+cpuclock_level_t CpuClock_GetLevel(void)
+{
+    return level;
+}
+
+/* returns current ahb frequency */
+uint32_t CpuClock_GetAHBHz(void)
+{
+    return ahb_hz;
+}
+
+/* returns current apb1 frequency */
+uint32_t CpuClock_GetAPB1Hz(void)
+{
+    return ahb_hz / apb1_div;
+}
+
+/* returns current apb2 frequency */
+uint32_t CpuClock_GetAPB2Hz(void)
+{
+    return ahb_hz;
+}
+
+/* start the clock governor */
+err_t CpuClock_GovernorInit(void)
+{
+    /* initialize the policy */
+    Governor_Init(&governor, CPUCLOCK_LEVEL_NUM);
+    /* drop the load accumulated so far */
+    uint32_t busy, total; Yield_ReadLoad(&busy, &total);
+
+    /* sample the load periodically */
+    return Timer_Start(&governor_timer, CpuClock_GovernorCallback, 0,
+        CPUCLOCK_GOVERNOR_PERIOD, CPUCLOCK_GOVERNOR_PERIOD);
+}
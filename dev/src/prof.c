@@ -0,0 +1,180 @@
+/**
+ * @file prof.c
+ *
+ * @author Tomasz Watorowski (tomasz.watorowski@gmail.com)
+ * @date 2025-04-18
+ *
+ * @brief Statistical profiler
+ */
+
+#include <stdint.h>
+
+#include "config.h"
+#include "compiler.h"
+#include "err.h"
+#include "dev/prof.h"
+#include "stm32f401/nvic.h"
+#include "stm32f401/timer.h"
+#include "sys/sleep.h"
+#include "sys/yield.h"
+#include "util/elems.h"
+
+#include "debug.h"
+#include "util/stdio.h"
+
+/* number of probes before giving up on finding the slot in the histogram */
+#define PROF_MAX_PROBES                     8
+
+/* histogram entry */
+typedef struct prof_entry {
+    /* sampled program counter and link register */
+    uint32_t pc, lr;
+    /* number of samples */
+    uint32_t count;
+} prof_entry_t;
+
+/* histogram size must be a power of 2 so that we can use masking */
+_Static_assert((PROF_HIST_SIZE & (PROF_HIST_SIZE - 1)) == 0,
+    "histogram size must be a power of 2");
+
+/* histogram itself (open addressing with linear probing) */
+static prof_entry_t hist[PROF_HIST_SIZE];
+/* total number of samples and the ones that did not fit into the histogram */
+static volatile uint32_t samples, dropped;
+
+/* store the sample, called from the isr with the exception stack frame */
+static void USED Prof_Sample(uint32_t *frame)
+{
+    /* clear the interrupt flag and schedule the next sample */
+    TIM3->SR = ~TIM_SR_CC1IF;
+    TIM3->CCR1 = (TIM3->CCR1 + PROF_SAMPLING_PERIOD_US) & 0xffff;
+
+    /* stacked pc and lr (with the thumb bit cleared) */
+    uint32_t pc = frame[6] & ~1, lr = frame[5] & ~1;
+    /* start probing from the hashed position */
+    uint32_t idx = ((pc >> 1) ^ (lr * 31)) & (PROF_HIST_SIZE - 1);
+
+    /* look for the matching or an empty entry */
+    for (int i = 0; i < PROF_MAX_PROBES; i++) {
+        prof_entry_t *e = &hist[(idx + i) & (PROF_HIST_SIZE - 1)];
+        /* empty entry, claim it */
+        if (!e->count)
+            e->pc = pc, e->lr = lr;
+        /* matching entry */
+        if (e->pc == pc && e->lr == lr) {
+            e->count++, samples++; return;
+        }
+    }
+
+    /* histogram is too crowded */
+    dropped++;
+}
+
+/* timer interrupt routine: pick the stack that the exception frame was pushed
+ * onto and pass the frame to the sampling routine */
+void NAKED Prof_TIM3Isr(void)
+{
+    ASM volatile (
+        "tst lr, #4             \n"
+        "ite eq                 \n"
+        "mrseq r0, msp          \n"
+        "mrsne r0, psp          \n"
+        "b Prof_Sample          \n"
+    );
+}
+
+/* periodically dump the profile */
+static void Prof_Task(void *arg)
+{
+    /* start sampling */
+    Prof_Start();
+    /* dump and start over */
+    for (;; Sleep(PROF_DUMP_INTERVAL))
+        Prof_Dump(), Prof_Reset();
+}
+
+/* initialize the profiler */
+err_t Prof_Init(void)
+{
+    /* set the interrupt priority */
+    NVIC_SETINTPRI(STM32_INT_TIM3, INT_PRI_PROF);
+    /* enable interrupt */
+    NVIC_ENABLEINT(STM32_INT_TIM3);
+
+    /* start dumping the profile on regular basis */
+    if (PROF_ENABLED && Yield_Task(Prof_Task, 0, 1024) < EOK)
+        return EFATAL;
+    /* report status */
+    return EOK;
+}
+
+/* start sampling */
+void Prof_Start(void)
+{
+    /* schedule the first sample */
+    TIM3->CCR1 = (TIM3->CNT + PROF_SAMPLING_PERIOD_US) & 0xffff;
+    TIM3->SR = ~TIM_SR_CC1IF;
+    /* enable the compare interrupt */
+    TIM3->DIER |= TIM_DIER_CC1IE;
+}
+
+/* stop sampling */
+void Prof_Stop(void)
+{
+    /* disable the compare interrupt */
+    TIM3->DIER &= ~TIM_DIER_CC1IE;
+}
+
+/* clear the histogram */
+void Prof_Reset(void)
+{
+    /* sampling state */
+    int sampling = TIM3->DIER & TIM_DIER_CC1IE;
+
+    /* clear with sampling paused */
+    Prof_Stop();
+    for (prof_entry_t *e = hist; e != hist + elems(hist); e++)
+        e->count = 0;
+    samples = dropped = 0;
+    /* resume sampling */
+    if (sampling)
+        TIM3->DIER |= TIM_DIER_CC1IE;
+}
+
+/* dump the profile */
+err_t Prof_Dump(void)
+{
+    /* sampling state, number of used entries */
+    int sampling = TIM3->DIER & TIM_DIER_CC1IE, entries = 0;
+    /* line buffer, dump goes out even if the debug messages are disabled */
+    char line[80]; int len;
+
+    /* pause sampling so that the histogram does not change under our feet */
+    Prof_Stop();
+
+    /* count the entries in use */
+    for (prof_entry_t *e = hist; e != hist + elems(hist); e++)
+        entries += e->count != 0;
+
+    /* header */
+    len = snprintf(line, sizeof(line),
+        "prof: begin period_us=%d samples=%u dropped=%u entries=%d\n",
+        PROF_SAMPLING_PERIOD_US, samples, dropped, entries);
+    Debug_Send(line, len);
+    /* all the entries */
+    for (prof_entry_t *e = hist; e != hist + elems(hist); e++) {
+        if (!e->count)
+            continue;
+        len = snprintf(line, sizeof(line), "prof: %08x %08x %u\n", e->pc,
+            e->lr, e->count);
+        Debug_Send(line, len);
+    }
+    /* footer */
+    Debug_Send("prof: end\n", 10);
+
+    /* resume sampling */
+    if (sampling)
+        TIM3->DIER |= TIM_DIER_CC1IE;
+    /* report status */
+    return EOK;
+}
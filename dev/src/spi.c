@@ -9,6 +9,7 @@
 
 #include "config.h"
 #include "err.h"
+#include "dev/cpuclock.h"
 #include "dev/dma.h"
 #include "dev/gpio_signals.h"
 #include "dev/spi.h"
@@ -18,6 +19,40 @@
 #include "sys/sem.h"
 #include "sys/yield.h"
 #include "sys/sleep.h"
+#include "util/elems.h"
+#include "util/msblsb.h"
+
+/* initialized devices, clock changes are held off while they transfer */
+static spi_dev_t *devs[4]; static int devs_num;
+
+/* tells if any of the devices is transferring, called with interrupts
+ * disabled */
+static int SPI_IsBusy(void)
+{
+    /* prescaler was computed for the clock that is currently in use */
+    for (int i = 0; i < devs_num; i++)
+        if ((devs[i]->spi->CR2 & (SPI_CR2_TXDMAEN | SPI_CR2_RXDMAEN)) ||
+            (devs[i]->spi->SR & SPI_SR_BSY))
+            return 1;
+    /* all quiet */
+    return 0;
+}
+
+/* compute the baud rate prescaler bits for requested speed */
+static uint32_t SPI_GetPrescaler(spi_dev_t *dev, spi_speed_t speed)
+{
+    /* spi1 and spi4 are placed on the apb2 */
+    uint32_t bus_hz = dev->spi == SPI1 || dev->spi == SPI4 ?
+        CpuClock_GetAPB2Hz() : CpuClock_GetAPB1Hz();
+    /* requested frequency: apb1 at the maximal speed divided by 2^(br + 1) */
+    uint32_t hz = APB1CLOCK_HZ >> ((speed >> LSB(SPI_CR1_BR)) + 1), br = 0;
+
+    /* find the smallest prescaler that does not exceed the requested speed */
+    while (br < 7 && (bus_hz >> (br + 1)) > hz)
+        br++;
+    /* encode */
+    return br << LSB(SPI_CR1_BR);
+}
 
 /* initialize common parts of the driver */
 err_t SPI_Init(void)
@@ -44,6 +79,13 @@ err_t SPI_DevInit(spi_dev_t *dev)
     /* enter cirtical section  */
     Critical_Enter();
 
+    /* do not let the clock change during the transfers */
+    if (devs_num == 0)
+        CpuClock_RegisterBusyCallback(SPI_IsBusy);
+    /* keep track of the device */
+    if (devs_num < elems(devs))
+        devs[devs_num++] = dev;
+
     /* select alternate function for all three pins */
     GPIOSig_CfgAltFunction(dev->sclk, GPIO_AF_SPI1_SPI2_I2S2_SPI3_I2S3_SPI4);
     GPIOSig_CfgAltFunction(dev->miso, GPIO_AF_SPI1_SPI2_I2S2_SPI3_I2S3_SPI4);
@@ -87,9 +129,8 @@ err_t SPI_Transfer(spi_dev_t *dev, spi_speed_t speed, spi_mode_t mode,
     if (size == 0)
         return EOK;
 
-    /* these are placed on the apb2 which is 2x as fast */
-    if (dev->spi == SPI1 || dev->spi == SPI4)
-        speed += 1 << LSB(SPI_CR1_BR);
+    /* prescaler for the current bus clock */
+    uint32_t br = SPI_GetPrescaler(dev, speed);
 
     /* disable the spi */
     dev->spi->CR1 &= ~SPI_CR1_SPE;
@@ -98,7 +139,7 @@ err_t SPI_Transfer(spi_dev_t *dev, spi_speed_t speed, spi_mode_t mode,
     dev->spi->CR2 &= ~(SPI_CR2_TXDMAEN | SPI_CR2_RXDMAEN);
     /* 0. setup speed */
     dev->spi->CR1 = (dev->spi->CR1 & ~(SPI_CR1_BR | SPI_CR1_CPOL | SPI_CR1_CPHA)) | 
-        speed | mode;
+        br | mode;
 
     /* 1. enable rx dma events generation */
     dev->spi->CR2 |= SPI_CR2_RXDMAEN;
@@ -142,6 +183,8 @@ err_t SPI_Transfer(spi_dev_t *dev, spi_speed_t speed, spi_mode_t mode,
             Yield(); us = Time_GetUS();
         }
     }
+    /* transfer is over, clock may change from now on */
+    dev->spi->CR2 &= ~(SPI_CR2_TXDMAEN | SPI_CR2_RXDMAEN);
 
     /* report status */
     return EOK;
@@ -9,24 +9,56 @@
 
 #include "config.h"
 #include "err.h"
+#include "dev/cpuclock.h"
 #include "sys/critical.h"
 #include "stm32f401/rcc.h"
 #include "stm32f401/timer.h"
 
-/* reset time base */
-int SysTime_Init(void)
+/* returns the timer clock frequency */
+static uint32_t SysTime_GetTimerClock(void)
 {
 	/* do we need to multiply the peripheral clock by 2? it is the case when 
 	 * peripheral clock is prescaled by RCC */
 	int mult = 1;
 
-	/* enter critical section */
-	Critical_Enter();
-
 	/* clock is prescaled */
 	if ((RCC->CFGR & RCC_CFGR_PPRE1) != RCC_CFGR_PPRE1_DIV1)
 		mult = 2;
-	
+	/* return the frequency */
+	return CpuClock_GetAPB1Hz() * mult;
+}
+
+/* apply new prescaler without disturbing the counter value */
+static void SysTime_SetPrescaler(tim_t *tim, uint32_t psc)
+{
+	/* store the counter */
+	uint32_t cnt = tim->CNT;
+	/* prescaler is only reloaded on the update event which resets the
+	 * counter */
+	tim->PSC = psc; tim->EGR = TIM_EGR_UG;
+	/* restore the counter */
+	tim->CNT = cnt;
+}
+
+/* clock has changed, called with interrupts disabled */
+static void SysTime_ClockChanged(void)
+{
+	/* timer clock */
+	uint32_t hz = SysTime_GetTimerClock();
+	/* keep the 1us and 100us ticks */
+	SysTime_SetPrescaler(TIM3, hz / 1000000 - 1);
+	SysTime_SetPrescaler(TIM2, hz / 10000 - 1);
+}
+
+/* reset time base */
+int SysTime_Init(void)
+{
+	/* timer clock */
+	uint32_t hz = SysTime_GetTimerClock();
+
+	/* enter critical section */
+	Critical_Enter();
+
 	/* enable tim2, tim6 clock */
 	RCC->APB1ENR |= RCC_APB1ENR_TIM3EN | RCC_APB1ENR_TIM2EN;
     /* wait for the timer to be started */
@@ -35,7 +67,7 @@ int SysTime_Init(void)
 
 
 	/* 1us per pulse (multiply by two may be needed)*/
-    TIM3->PSC = (APB1CLOCK_HZ * mult) / 1000000 - 1;
+    TIM3->PSC = hz / 1000000 - 1;
     /* maximal automatic reload value */
     TIM3->ARR = 0xffff;
     /* reload prescaler */
@@ -44,7 +76,7 @@ int SysTime_Init(void)
     TIM3->CR1 = TIM_CR1_CEN;
 
 	/* set prescaler to obtain 100us pulse */
-	TIM2->PSC = ((APB1CLOCK_HZ * mult) / 10000) - 1;
+	TIM2->PSC = hz / 10000 - 1;
 	/* set autoreload value */
 	TIM2->ARR = 0xffffffff;
 	/* reset value */
@@ -54,6 +86,9 @@ int SysTime_Init(void)
 	/* enable timer */
 	TIM2->CR1 = TIM_CR1_CEN;
 
+	/* follow the clock changes */
+	CpuClock_RegisterCallback(SysTime_ClockChanged);
+
 	/* exit critical section */
 	Critical_Exit();
 
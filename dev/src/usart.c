@@ -14,6 +14,7 @@
 
 #include "config.h"
 #include "err.h"
+#include "dev/cpuclock.h"
 #include "dev/dma.h"
 #include "dev/gpio.h"
 #include "dev/gpio_signals.h"
@@ -30,6 +31,49 @@
 #include "util/msblsb.h"
 #include "util/string.h"
 
+/* initialized devices, baud rates are recomputed when the clock changes */
+static usart_dev_t *devs[3]; static int devs_num;
+/* rx dma counters as seen during the last busy check */
+static size_t rx_left[elems(devs)];
+
+/* returns the clock of the bus that the usart is connected to */
+static uint32_t USART_GetBusClock(usart_dev_t *dev)
+{
+    return dev->usart == USART2 ? CpuClock_GetAPB1Hz() : CpuClock_GetAPB2Hz();
+}
+
+/* clock has changed, called with interrupts disabled */
+static void USART_ClockChanged(void)
+{
+    /* baud rate generator is fed from the bus clock */
+    for (int i = 0; i < devs_num; i++)
+        devs[i]->usart->BRR = USART_GetBusClock(devs[i]) / devs[i]->baudrate;
+}
+
+/* tells if any of the devices is transmitting or receiving, called with
+ * interrupts disabled */
+static int USART_IsBusy(void)
+{
+    /* check all the devices */
+    for (int i = 0; i < devs_num; i++) {
+        /* shorthand */
+        usart_dev_t *dev = devs[i];
+        /* dma is still feeding the data or the last frame is on the wire */
+        if ((dev->tx.stream->CR & DMA_CR_EN) ||
+            !(dev->usart->SR & USART_SR_TC))
+            return 1;
+
+        /* remote site has no idea about our clock: frames that arrived since
+         * the last check tell that it is likely to keep sending, low rxd
+         * line means that the frame is being received right now */
+        size_t left = DMA_GetSize(dev->rx.stream);
+        if (left != rx_left[i] || !GPIOSig_Get(dev->rxd)) {
+            rx_left[i] = left; return 1;
+        }
+    }
+    /* all quiet */
+    return 0;
+}
 
 /* initialize common part of the driver */
 err_t USART_Init(void)
@@ -41,6 +85,10 @@ err_t USART_Init(void)
     RCC->APB1ENR |= RCC_APB1ENR_USART2EN;
     /* enable power supplies for the usarts located at apb2 bus */
     RCC->APB2ENR |= RCC_APB2ENR_USART1EN | RCC_APB2ENR_USART6EN;
+    /* follow the clock changes */
+    CpuClock_RegisterCallback(USART_ClockChanged);
+    /* and hold them off while transmitting */
+    CpuClock_RegisterBusyCallback(USART_IsBusy);
 
     /* exit critical section */
     Critical_Exit();
@@ -57,11 +105,15 @@ err_t USART_DevInit(usart_dev_t *dev)
     gpio_af_t af = dev->usart == USART6 ? GPIO_AF_USART6 : 
         GPIO_AF_SPI3_I2S3_USART1_USART2;
     /* get the clock base for given peripherals */
-    int bus_clock = dev->usart == USART2 ? APB1CLOCK_HZ : APB2CLOCK_HZ;
+    uint32_t bus_clock = USART_GetBusClock(dev);
 
     /* enter critical section */
     Critical_Enter();
 
+    /* keep track of the device for the clock changes */
+    if (devs_num < elems(devs))
+        devs[devs_num++] = dev;
+
     /* configure pins */
     GPIOSig_CfgAltFunction(dev->rxd, af);
     GPIOSig_CfgAltFunction(dev->txd, af);
@@ -114,7 +166,7 @@ err_t USART_DevInit(usart_dev_t *dev)
 err_t USART_SetBaudrate(usart_dev_t *dev, int baudrate)
 {
     /* get the clock base for given peripherals */
-    int bus_clock = dev->usart == USART2 ? APB1CLOCK_HZ : APB2CLOCK_HZ;
+    uint32_t bus_clock = USART_GetBusClock(dev);
     /* configure baud rate */
     uint32_t brr = bus_clock / baudrate;
 
@@ -134,7 +186,7 @@ err_t USART_SetBaudrate(usart_dev_t *dev, int baudrate)
     dev->usart->CR1 |= USART_CR1_UE | USART_CR1_RE | USART_CR1_TE;
 
     /* store new baudrate within the device descriptor */
-    dev->baudrate = brr;
+    dev->baudrate = baudrate;
     /* report status */
     return EOK;
 }
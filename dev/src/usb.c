@@ -7,7 +7,9 @@
  */
 
 #include "assert.h"
+#include "compiler.h"
 #include "err.h"
+#include "dev/cpuclock.h"
 #include "dev/gpio.h"
 #include "dev/gpio_signals.h"
 #include "dev/usb.h"
@@ -31,8 +33,9 @@
 #define DEBUG DLVL_ERROR
 #include "debug.h"
 
-/* system events */
-ev_t usb_ev;
+/* system events (argument lives on the stack of the interrupt so it is
+ * copied into the mailboxes) */
+ev_t usb_ev = { .arg_size = sizeof(usb_evarg_t) };
 
 /* in/out endpoint related stuff */
 typedef struct {
@@ -77,7 +80,7 @@ static void USB_FinishTransfer(usb_ep_t *ep, err_t ec)
 }
 
 /* dump the packet from the rx fifo */
-static size_t USB_DumpPacket(size_t size)
+static size_t HOT USB_DumpPacket(size_t size)
 {
     /* number of bytes that we need to read rounded up to full 32 bit words
      * that fifo is organized around */
@@ -91,7 +94,7 @@ static size_t USB_DumpPacket(size_t size)
 }
 
 /* read usb packet */
-static size_t USB_ReadPacket(void *ptr, size_t size)
+static size_t HOT USB_ReadPacket(void *ptr, size_t size)
 {
 	/* data pointer */
 	uint8_t *p = ptr; size_t b_left;
@@ -120,7 +123,8 @@ static size_t USB_ReadPacket(void *ptr, size_t size)
 }
 
 /* write usb packet */
-static size_t USB_WritePacket(int ep_num, const void *ptr, size_t size)
+static size_t HOT USB_WritePacket(int ep_num, const void *ptr,
+    size_t size)
 {
 	/* data pointer */
 	const uint8_t *p = ptr; size_t sz;
@@ -188,12 +192,26 @@ static void USB_HandleReset(void)
 	USBFS->GINTSTS = USB_GINTSTS_USBRST;
 }
 
+/* configure turnaround time for full speed according to ahb frequency */
+static void USB_SetTurnaroundTime(void)
+{
+	/* current ahb frequency in MHz */
+	uint32_t mhz = CpuClock_GetAHBHz() / 1000000;
+	/* values from the reference manual (minimal ahb frequency is 14.2MHz) */
+	uint32_t trdt = mhz >= 32 ? 0x6 : mhz >= 27 ? 0x7 : mhz >= 24 ? 0x8 :
+		mhz >= 21 ? 0x9 : mhz >= 20 ? 0xa : mhz >= 18 ? 0xb : mhz >= 17 ? 0xc :
+		mhz >= 16 ? 0xd : mhz >= 15 ? 0xe : 0xf;
+
+	/* apply */
+	USBFS->GUSBCFG = (USBFS->GUSBCFG & ~USB_GUSBCFG_TRDT) |
+		  trdt << LSB(USB_GUSBCFG_TRDT);
+}
+
 /* handle enumaration done */
 static void USB_HandleEnum(void)
 {
 	/* configure turnaround time for full speed according to ahb frequency */
-	USBFS->GUSBCFG = (USBFS->GUSBCFG & ~USB_GUSBCFG_TRDT) |
-		  0x6 << LSB(USB_GUSBCFG_TRDT);
+	USB_SetTurnaroundTime();
 
 	/* set in endpoint in error state */
     for (usb_ep_t *in = ep_in; in != ep_in + elems(ep_in); in++)
@@ -456,6 +474,9 @@ err_t USB_Init(void)
     GPIOSig_CfgPull((gpio_signal_t)GPIO_SIGNAL_BLACKPILL_A12,
         GPIO_OSPEED_HIGH);
 
+    /* turnaround time depends on the ahb clock */
+    CpuClock_RegisterCallback(USB_SetTurnaroundTime);
+
 	/* disable the interrupts */
 	USBFS->GAHBCFG &= ~USB_GAHBCFG_GINTMSK;
 	/* Init the Core (common init.) */
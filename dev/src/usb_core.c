@@ -17,8 +17,9 @@
 #include "debug.h"
 
 
-/* core events */
-ev_t usbcore_req_ev;
+/* core events (argument lives on the stack so it is copied into the
+ * mailboxes, listeners cannot report the status back) */
+ev_t usbcore_req_ev = { .arg_size = sizeof(usbcore_req_evarg_t) };
 
 /* control endpoint setup frame buffer: max three back to back setup frames can be
  * received */
@@ -6,6 +6,7 @@
  * @copyright Copyright (c) 2024
  */
 
+#include "assert.h"
 #include "compiler.h"
 #include "config.h"
 #include "err.h"
@@ -13,9 +14,11 @@
 #include "dev/usb_core.h"
 #include "dev/usb_desc.h"
 #include "dev/usb_eem.h"
+#include "sys/heap.h"
 #include "sys/sem.h"
 #include "sys/sleep.h"
 #include "sys/queue.h"
+#include "sys/sysconf.h"
 #include "util/minmax.h"
 #include "util/string.h"
 #include "util/elems.h"
@@ -26,18 +29,31 @@
 
 /* buffer element */
 typedef struct buf {
-	/* current size of the data being stored */
-	size_t size, offs;
-	/* payload size for the ethernet frame + the eem header */
-	uint8_t pld[USBEEM_MAX_ETH_FRAME_LEN];
+	/* current size of the ethernet frame being stored, number of references
+	 * held */
+	size_t size, refs;
+	/* eem header, the ethernet frame and the crc trailer laid out the way
+	 * they go over the wire (ethernet frame is built in place) */
+	uint8_t ALIGNED(4) data[USBEEM_BUF_SIZE];
 } buf_t;
 
-/* buffers for rx frames and tx frames */
-static buf_t rx[USBEEM_RX_BUF_CAPACITY], tx[USBEEM_TX_BUF_CAPACITY];
-/* head and tail pointers ro the reception */
-static uint32_t rx_head, rx_tail;
-/* head and tail pointers for the transmission */
-static uint32_t tx_head, tx_tail;
+/* received ethernet frame: the buffer that holds the transfer and the
+ * location of the frame within it */
+typedef struct rx_frame {
+	/* buffer index */
+	uint32_t id;
+	/* offset of the ethernet frame within the buffer and it's size */
+	uint16_t offs, size;
+} rx_frame_t;
+
+/* buffers for rx frames and tx frames (sized at boot, see sysconf.h) */
+static buf_t *rx, *tx; static uint32_t rx_num, tx_num;
+/* queue of received frames that wait for being picked up along with it's
+ * head and tail pointers */
+static rx_frame_t *rx_q; static uint32_t rx_head, rx_tail;
+/* queue of transmission buffers to be sent (buffer indices) along with it's
+ * head and tail pointers */
+static uint32_t *tx_q, tx_head, tx_tail;
 /* endianness mode: windows uses big endian, linux uses little endian as in
 documentation. bill gates i fokkin hate you!!!11 */
 static enum endiannes {
@@ -99,30 +115,46 @@ static void USBEEM_ExtractHdrFields(enum endiannes end, uint16_t hdr,
 /* reception task */
 static void USBEEM_RxTask(void *arg)
 {
-	/* buffer for receiving transfers. in eem synchronization takes place at
-	 * transfer level, so you cannot accept less than one ethernet frame worth
-	 * of data */
-	static uint8_t transfer[1518 + 4 + sizeof(usbeem_hdr_t)];
 	/* extracted fields from the header */
-	int type, cmd; size_t pld_len;
+	int type, cmd; size_t pld_len; uint32_t id;
 
 	/* endless loop of listening on the endpoint */
 	for (;; Yield()) {
+		/* look for the buffer that nobody holds (frames from the previous
+		 * transfers may still be processed) */
+		for (id = 0; id < rx_num && rx[id].refs; id++);
+		/* all buffers are in use */
+		if (id == rx_num)
+			continue;
+
+		/* in eem synchronization takes place at transfer level, so you
+		 * cannot accept less than one ethernet frame worth of data. transfer
+		 * goes directly to the buffer and the frames are handed out from
+		 * there */
+		uint8_t *transfer = rx[id].data;
+		/* we hold the buffer for the time of the transfer processing */
+		rx[id].refs = 1;
 		/* start the transfer */
-		err_t ec = USB_StartOUTTransfer(USB_EP3, transfer, sizeof(transfer), 0);
+		err_t ec = USB_StartOUTTransfer(USB_EP3, transfer, USBEEM_BUF_SIZE, 0);
 		/* transfer already started */
-		if (ec < EOK)
-			continue;
+		if (ec < EOK) {
+			rx[id].refs = 0; continue;
+		}
 		/* wait for the transfer to finish */
 		ec = USB_WaitOUTTransfer(USB_EP3, 0);
 		/* transfer finished but with an error */
-		if (ec < EOK)
-			continue;
+		if (ec < EOK) {
+			rx[id].refs = 0; continue;
+		}
 
 		/* show that we have received a frame */
 		dprintf_d("RX: processing transfer: size  %d\n", ec);
 		/* process all the data from the transfer */
 		for (size_t size = ec, offs = 0; offs < size;) {
+			/* stray bytes at the end of the transfer that cannot hold the
+			 * header, this also keeps the size checks below from wrapping */
+			if (size - offs < sizeof(usbeem_frame_t))
+				break;
 			/* point to the beginning of eem frame */
 			usbeem_frame_t *frame = (usbeem_frame_t *)(transfer + offs);
 
@@ -173,100 +205,94 @@ static void USBEEM_RxTask(void *arg)
 			 * if not then this frame is malformed */
 			if (pld_len < 4)
 				break;
+			/* frame does not fit within the bytes that remain in the
+			 * transfer */
+			if (pld_len > size - offs - sizeof(*frame))
+				break;
+			/* nothing but the checksum */
+			if (pld_len == 4)
+				goto next_frame;
 
-			/* transfer the ethernet data to the buffer */
-			/* wait for the rx buffer slot to become empty */
-			for (; rx_head - rx_tail == elems(rx); Yield());
-			/* get the pointer to the buffer slot */
-			buf_t *buf = &rx[rx_head % elems(rx)];
-
-			/* limit the copy size so that we do not overflow, also skip the
-			 * checksum */
-			size_t copy_size = min(sizeof(buf->pld), pld_len - 4);
-			/* copy the data */
-			memcpy(buf->pld, frame->pld, copy_size);
-			/* store the size */
-			buf->size = copy_size;
-			/* mark buffer as busy */
-			rx_head++;
+			/* wait for the space in the queue */
+			for (; rx_head - rx_tail == rx_num; Yield());
+			/* hand out the ethernet frame by reference (checksum is
+			 * skipped), the queue entry holds the reference to the buffer */
+			rx_q[rx_head % rx_num] = (rx_frame_t){ .id = id,
+				.offs = offs + sizeof(*frame), .size = pld_len - 4 };
+			rx[id].refs++, rx_head++;
 
 			/* display debug */
-			dprintf_d("RX: size %d out of %d\n", copy_size, pld_len);
+			dprintf_d("RX: size %d\n", pld_len - 4);
 			/* update the offset */
 			next_frame: offs += pld_len + sizeof(*frame);
 		}
+
+		/* buffer becomes free once all the frames are processed */
+		rx[id].refs--;
 	}
 }
 
 /* transmission task */
 static void USBEEM_TxTask(void *arg)
 {
-	/* buffer for receiving transfers. in eem synchronization takes place at
-	 * transfer level, so you cannot accept less than one ethernet frame worth
-	 * of data */
-	static uint8_t transfer[1518 + 4 + sizeof(usbeem_hdr_t)];
-
-
 	/* endless transmission loop */
 	for (;; Yield()) {
-		/* offset within the transfer */
-		size_t offs, cnt = 0; uint32_t tail = tx_tail;
-
-		/* endianness was not determined, do not send anything */
-		if (endiannes == END_UNKNOWN)
+		/* endianness was not determined or there is nothing to be sent */
+		if (endiannes == END_UNKNOWN || tx_head == tx_tail)
 			continue;
 
-		/* eem allows to pack as many frames as you want in a single transfer */
-		for (offs = 0; tx_head != tail; ) {
-			/* get the buffer pointer */
-			buf_t *buf = &tx[tail % elems(tx)];
-			/* compute the size of the usb data that we'll need to send because
-			 * of this frame. additional 4 bytes come from ethernet checksum */
-			size_t frame_size = buf->size + sizeof(usbeem_hdr_t) + 4;
-			/* we cannot add this frame to the transfer */
-			if (frame_size > sizeof(transfer) - offs)
-				break;
-
-			/* map the header onto the transfer buffer */
-			usbeem_frame_t *frame = (usbeem_frame_t *)(transfer + offs);
-			/* compose the header */
-			frame->hdr = USBEEM_HDR_TYPE_DATA | USBEEM_HDR_DATA_CRC_DEADBEEF |
-				((buf->size + 4) << LSB(USBEEM_HDR_DATA_LENGTH));
-			/* set the endianness */
-			frame->hdr = endiannes == END_LE ? HTOLE16(frame->hdr) :
-				HTOBE16(frame->hdr);
-
-			/* copy the payload */
-			memcpy(frame->pld, buf->pld, buf->size);
-			/* add bogus checksum */
-			frame->pld[buf->size + 0] = endiannes == END_LE ? 0xde : 0xde;//0xef;
-			frame->pld[buf->size + 1] = endiannes == END_LE ? 0xad : 0xad;//0xbe;
-			frame->pld[buf->size + 2] = endiannes == END_LE ? 0xbe : 0xbe;//0xad;
-			frame->pld[buf->size + 3] = endiannes == END_LE ? 0xef : 0xef;//0xde;
-			/* update the offset, consume the frame */
-			offs += frame_size; tail++; cnt++;
-		}
-		/* no frames to be sent */
-		if (!offs)
-			continue;
-
-		/* try to send, if unsuccesfull, bail */
-		if (USB_StartINTransfer(USB_EP3, transfer, offs, 0) < EOK)
+		/* get the buffer pointer */
+		buf_t *buf = &tx[tx_q[tx_tail % tx_num]];
+		/* size of the usb data, additional 4 bytes come from ethernet
+		 * checksum */
+		size_t size = buf->size + USBEEM_BUF_HEADROOM + 4;
+		/* map the header onto the headroom */
+		usbeem_frame_t *frame = (usbeem_frame_t *)buf->data;
+
+		/* compose the header */
+		frame->hdr = USBEEM_HDR_TYPE_DATA | USBEEM_HDR_DATA_CRC_DEADBEEF |
+			((buf->size + 4) << LSB(USBEEM_HDR_DATA_LENGTH));
+		/* set the endianness */
+		frame->hdr = endiannes == END_LE ? HTOLE16(frame->hdr) :
+			HTOBE16(frame->hdr);
+		/* add bogus checksum */
+		frame->pld[buf->size + 0] = 0xde; frame->pld[buf->size + 1] = 0xad;
+		frame->pld[buf->size + 2] = 0xbe; frame->pld[buf->size + 3] = 0xef;
+
+		/* the frame goes directly from the buffer (one frame per transfer),
+		 * if unsuccesfull, bail */
+		if (USB_StartINTransfer(USB_EP3, buf->data, size, 0) < EOK)
 			continue;
 
 		/* wait for the transfer to finish */
 		err_t ec = USB_WaitINTransfer(USB_EP3, 0);
-		/* transfer is now complete, we may consume the buffer */
-		if (ec >= EOK)
-			tx_tail = tail;
+		/* transfer is now complete, queue's reference to the buffer is
+		 * released */
+		if (ec >= EOK) {
+			USBEEM_ReleaseTx(tx_q[tx_tail % tx_num]); tx_tail++;
+		}
 		/* brag */
-		dprintf_d("TX sending frame: size = %d, ec = %d\n", offs, ec);
+		dprintf_d("TX sending frame: size = %d, ec = %d\n", size, ec);
 	}
 }
 
 /* initialize virtual com port logic */
 err_t USBEEM_Init(void)
 {
+	/* allocate frame buffers */
+	rx_num = sysconf.eem_rx_buf_num, tx_num = sysconf.eem_tx_buf_num;
+	rx = Heap_Malloc(rx_num * sizeof(*rx));
+	tx = Heap_Malloc(tx_num * sizeof(*tx));
+	rx_q = Heap_Malloc(rx_num * sizeof(*rx_q));
+	tx_q = Heap_Malloc(tx_num * sizeof(*tx_q));
+	/* sanity check */
+	assert(rx && tx && rx_q && tx_q, "unable to allocate usb eem buffers");
+	/* all buffers are free */
+	for (uint32_t i = 0; i < rx_num; i++)
+		rx[i].refs = 0;
+	for (uint32_t i = 0; i < tx_num; i++)
+		tx[i].refs = 0;
+
 	/* start tasks */
 	Yield_Task(USBEEM_RxTask, 0, 1024);
 	Yield_Task(USBEEM_TxTask, 0, 1024);
@@ -279,8 +305,8 @@ err_t USBEEM_Init(void)
 	return EOK;
 }
 
-/* receive data from virtual com port */
-err_t USBEEM_Recv(void *ptr, size_t size, dtime_t timeout)
+/* receive the frame */
+err_t USBEEM_RecvRx(void **ptr, int *id, dtime_t timeout)
 {
 	/* waiting loop */
 	for (dtime_t ts = time(0); rx_head - rx_tail == 0; Yield()) {
@@ -295,29 +321,40 @@ err_t USBEEM_Recv(void *ptr, size_t size, dtime_t timeout)
 			return EUSB_INACTIVE;
 	}
 
-	/* get the buffer pointer */
-	buf_t *buf = &rx[rx_tail % elems(rx)];
-
-	/* limit the size */
-	size = min(size, buf->size);
-	/* copy data */
-	memcpy(ptr, buf->pld, size);
-	/* mark as free */
-	rx_tail++;
+	/* consume the queue entry, it's reference goes to the caller */
+	rx_frame_t *f = &rx_q[rx_tail++ % rx_num];
+	/* frame stays where it was received */
+	*ptr = rx[f->id].data + f->offs, *id = f->id;
 
-	/* return the size of the data */
-	return size;
+	/* return the size of the frame */
+	return f->size;
 }
 
-/* send the data over the eem */
-err_t USBEEM_Send(const void *ptr, size_t size, dtime_t timeout)
+/* release the reception buffer */
+err_t USBEEM_ReleaseRx(int id)
 {
-	/* frame to be sent is wayy to big */
-	if (size > USBEEM_MAX_ETH_FRAME_LEN)
+	/* buffer is not held by anyone */
+	if (id < 0 || (uint32_t)id >= rx_num || !rx[id].refs)
 		return EARGVAL;
+	/* buffer becomes free with the last reference gone */
+	rx[id].refs--;
+	/* report status */
+	return EOK;
+}
 
-	/* wait for the transmission buffer to become empty */
-	for (dtime_t ts = time(0); tx_head - tx_tail == elems(tx); Yield()) {
+/* allocate the transmission buffer */
+err_t USBEEM_AllocTx(void **ptr, dtime_t timeout)
+{
+	/* buffer index */
+	uint32_t id;
+
+	/* wait for the transmission buffer to become free */
+	for (dtime_t ts = time(0); ; Yield()) {
+		/* look for the buffer that nobody holds */
+		for (id = 0; id < tx_num && tx[id].refs; id++);
+		/* got one */
+		if (id < tx_num)
+			break;
 		/* support for timoeut */
 		if (timeout && dtime_now(ts) > timeout)
 			return ETIMEOUT;
@@ -329,12 +366,52 @@ err_t USBEEM_Send(const void *ptr, size_t size, dtime_t timeout)
 			return EUSB_INACTIVE;
 	}
 
-	/* get the pointer to the buffer element that we are about to fill */
-	buf_t *buf = &tx[tx_head % elems(tx)];
-	/* store the payload */
-	memcpy(buf->pld, ptr, buf->size = size);
-	/* mark as ready to be sent */
-	tx_head++;
+	/* caller holds the reference */
+	tx[id].refs = 1, tx[id].size = 0;
+	/* ethernet frame goes after the eem header */
+	*ptr = tx[id].data + USBEEM_BUF_HEADROOM;
+	/* return the buffer index */
+	return id;
+}
+
+/* take the reference to the transmission buffer */
+err_t USBEEM_RefTx(int id)
+{
+	/* buffer needs to be held by someone already */
+	if (id < 0 || (uint32_t)id >= tx_num || !tx[id].refs)
+		return EARGVAL;
+	/* bump up the counter */
+	tx[id].refs++;
+	/* report status */
+	return EOK;
+}
+
+/* release the reference to the transmission buffer */
+err_t USBEEM_ReleaseTx(int id)
+{
+	/* buffer is not held by anyone */
+	if (id < 0 || (uint32_t)id >= tx_num || !tx[id].refs)
+		return EARGVAL;
+	/* buffer becomes free with the last reference gone */
+	tx[id].refs--;
+	/* report status */
+	return EOK;
+}
+
+/* queue the transmission buffer for sending */
+err_t USBEEM_SendTx(int id, size_t size)
+{
+	/* frame to be sent is wayy to big */
+	if (size > USBEEM_MAX_ETH_FRAME_LEN)
+		return EARGVAL;
+	/* transmission queue holds it's own reference */
+	if (USBEEM_RefTx(id) != EOK)
+		return EARGVAL;
+
+	/* store the size of the frame */
+	tx[id].size = size;
+	/* queue is large enough to hold all the buffers */
+	tx_q[tx_head++ % tx_num] = id;
 
 	/* return the size of the data */
 	return size;
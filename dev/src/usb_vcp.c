@@ -135,20 +135,25 @@ static void USBVCP_RxTask(void *arg)
 /* transmission task */
 static void USBVCP_TxTask(void *arg)
 {
-	/* buffer for receiving transfers from the endpoint, we use static to use
-	 * less memory from the task's stack */
-	uint8_t buf[USB_VCP_TX_SIZE];
+	/* view of the data stored within the queue, frames are sent directly
+	 * from the queue memory */
+	queue_span_t span;
 	/* error code */
 	err_t ec;
 
 	/* endless transmission loop */
 	for (;; Yield()) {
-		/* get data from transmission queue */
-		size_t size = Queue_GetWait(txq, buf, sizeof(buf), 5);
+		/* give the producers some time to fill in the whole frame */
+		Queue_WaitLevel(txq, USB_VCP_TX_SIZE, 5);
+		/* get the data from transmission queue, wrapped part will be sent
+		 * during the next iteration */
+		Queue_PeekLinear(txq, USB_VCP_TX_SIZE, &span);
+		/* data pointer and size */
+		uint8_t *p8 = span.seg[0].ptr; size_t size = span.seg[0].count;
 		/* send frames */
 		for (size_t offs = 0; offs != size; Yield()) {
 			/* try to initiate the transfer */
-			ec = USB_StartINTransfer(USB_EP2, buf + offs, size, 0);
+			ec = USB_StartINTransfer(USB_EP2, p8 + offs, size - offs, 0);
 			if (ec < EOK)
 				continue;
 			/* wait for the transfer to finish */
@@ -157,6 +162,8 @@ static void USBVCP_TxTask(void *arg)
 			if (ec > EOK)
 				offs += ec;
 		}
+		/* data was sent, release the queue memory */
+		Queue_Consume(txq, size);
 	}
 }
 
@@ -0,0 +1,36 @@
+/**
+ * @file systime.h
+ *
+ * @date 2021-01-26
+ * twatorowski (tomasz.watorowski@gmail.com)
+ *
+ * @brief System timer: free running TIM2 (100us ticks) and TIM3 (1us ticks)
+ */
+
+#ifndef DEV_SYSTIME_H
+#define DEV_SYSTIME_H
+
+#include <stdint.h>
+
+/**
+ * @brief reset time base
+ *
+ * @return int status
+ */
+int SysTime_Init(void);
+
+/**
+ * @brief get time
+ *
+ * @return uint32_t timer value in 100us ticks
+ */
+uint32_t SysTime_GetTime(void);
+
+/**
+ * @brief get current microsecond timer value
+ *
+ * @return uint16_t timer value in us
+ */
+uint16_t SysTime_GetUs(void);
+
+#endif /* DEV_SYSTIME_H */
@@ -9,6 +9,7 @@
 #ifndef DEV_USB_EEM_H
 #define DEV_USB_EEM_H
 
+#include "config.h"
 #include "err.h"
 #include "sys/time.h"
 
@@ -54,6 +55,13 @@
 /* special packet */
 #define USBEEM_HDR_ZLP                                  0x0000
 
+/* space reserved in front of the ethernet frame within the buffer (eem
+ * header) */
+#define USBEEM_BUF_HEADROOM                             2
+/* size of the buffer: eem header, the ethernet frame and it's checksum */
+#define USBEEM_BUF_SIZE                                 \
+    (USBEEM_BUF_HEADROOM + USBEEM_MAX_ETH_FRAME_LEN + 4)
+
 /** struct that holds the header  */
 typedef struct usbeem_hdr {
     uint16_t hdr;
@@ -71,10 +79,76 @@ typedef struct usbeem_frame {
 
 /* initialize virtual com port logic */
 err_t USBEEM_Init(void);
-/* send data to virtual com port */
-err_t USBEEM_Send(const void *ptr, size_t size, dtime_t timeout);
-/* receive data from virtual com port */
-err_t USBEEM_Recv(void *ptr, size_t size, dtime_t timeout);
+
+/**
+ * @brief allocate the transmission buffer. The ethernet frame is built in
+ * place and handed over to the usb transfer without being copied. The caller
+ * holds a single reference to the buffer.
+ *
+ * @param ptr placeholder for the pointer to the ethernet frame area (of
+ * USBEEM_MAX_ETH_FRAME_LEN bytes, eem header and checksum are taken care of)
+ * @param timeout max time to wait for the buffer to become free (0 - forever)
+ *
+ * @return err_t buffer id (non-negative) or error code
+ */
+err_t USBEEM_AllocTx(void **ptr, dtime_t timeout);
+
+/**
+ * @brief take another reference to the transmission buffer
+ *
+ * @param id buffer id
+ *
+ * @return err_t error code
+ */
+err_t USBEEM_RefTx(int id);
+
+/**
+ * @brief release the reference to the transmission buffer, buffer is free to
+ * be allocated again once all the references are gone
+ *
+ * @param id buffer id
+ *
+ * @return err_t error code
+ */
+err_t USBEEM_ReleaseTx(int id);
+
+/**
+ * @brief queue the transmission buffer for sending. Transmission queue takes
+ * it's own reference that is released when the usb transfer completes, caller
+ * still needs to release it's one.
+ *
+ * @param id buffer id
+ * @param size size of the ethernet frame
+ *
+ * @return err_t size of the frame or error code
+ */
+err_t USBEEM_SendTx(int id, size_t size);
+
+/**
+ * @brief receive the ethernet frame. Frame is not copied: it stays within the
+ * reception buffer that the usb transfer went to and the caller takes over
+ * the reference to that buffer which needs to be released with
+ * USBEEM_ReleaseRx() when the frame is processed. Buffer takes the next usb
+ * transfer when all of it's frames are released.
+ *
+ * @param ptr placeholder for the pointer to the ethernet frame (checksum
+ * excluded)
+ * @param id placeholder for the buffer id
+ * @param timeout max time to wait for the frame (0 - forever)
+ *
+ * @return err_t size of the frame or error code
+ */
+err_t USBEEM_RecvRx(void **ptr, int *id, dtime_t timeout);
+
+/**
+ * @brief release the reference to the reception buffer taken with
+ * USBEEM_RecvRx()
+ *
+ * @param id buffer id
+ *
+ * @return err_t error code
+ */
+err_t USBEEM_ReleaseRx(int id);
 
 
 #endif /* DEV_USB_EEM_H */
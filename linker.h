@@ -22,7 +22,8 @@ extern char __stack;
 
 /* flash vectors address */
 extern char __flash_vectors;
-/* total code size and it's initial position */
+/* total code size and it's initial position (code is split by the flash
+ * storage sector which is included in the size) */
 extern char __flash_code_addr, __flash_code_size;
 /* complete flash image size (code + data initializers) */
 extern char __flash_image_size;
@@ -30,6 +31,9 @@ extern char __flash_image_size;
 /* flash storage size */
 extern char __flash_strg_addr, __flash_strg_size;
 
+/* start of the dynamic memory (end of the statically allocated data) */
+extern char __heap_addr;
+
 /* data initialization by flash stored data */
 /* source address */
 extern char __flash_sram_init_src_addr;
@@ -37,6 +41,8 @@ extern char __flash_sram_init_src_addr;
 extern char __ram_code_addr, __data_addr;
 /* size */
 extern char __ram_code_size, __data_size;
+/* hot code (part of the ram code) address and size */
+extern char __hot_code_addr, __hot_code_size;
 
 /* data initialization by zeroing out */
 /* bss section */
@@ -8,6 +8,7 @@
  */
 
 #include "compiler.h"
+#include "config.h"
 #include "vectors.h"
 
 #include "dev/analog.h"
@@ -16,11 +17,13 @@
 #include "dev/fpu.h"
 #include "dev/gpio.h"
 #include "dev/led.h"
+#include "dev/prof.h"
 #include "dev/seed.h"
 #include "dev/spi_dev.h"
 #include "dev/spi.h"
 #include "dev/swi2c_dev.h"
 #include "dev/swi2c.h"
+#include "dev/systime.h"
 #include "dev/usart_dev.h"
 #include "dev/usart.h"
 #include "dev/usb_core.h"
@@ -37,7 +40,10 @@
 #include "sys/queue.h"
 #include "sys/sem.h"
 #include "sys/sleep.h"
+#include "sys/sysconf.h"
+#include "sys/timer.h"
 #include "sys/yield.h"
+#include "test/bench.h"
 #include "util/jenkins.h"
 #include "util/string.h"
 #include "www/api.h"
@@ -70,8 +76,10 @@ void Init(void)
     /* initialize reset source */
     Reset_Init();
 
+    /* load the pool sizes from the persisted configuration */
+    SysConf_Init();
     /* initialize dynamic memory */
-    Heap_Init();
+    Heap_Init(SysConf_GetHeapAddr(), sysconf.heap_size);
     /* initialize system timer */
     Time_Init();
     /* get the debugging going if in development mode */
@@ -98,6 +106,15 @@ void Main(void *arg)
     FPU_Init();
     /* configure the system clock */
     CpuClock_Init();
+    /* start the software timer service */
+    Timer_Init();
+    /* scale the clock according to the load */
+    if (CPUCLOCK_GOVERNOR_ENABLED)
+        CpuClock_GovernorInit();
+    /* start the free running timers */
+    SysTime_Init();
+    /* initialize the profiler */
+    Prof_Init();
 
     /* initialize gpio */
     GPIO_Init();
@@ -147,6 +164,8 @@ void Main(void *arg)
 
     /* initialize http website server */
     HTTPSrvWebsite_Init();
+    /* and the api server */
+    HTTPSrvApi_Init();
 
     /* print a welcome message */
     dprintf(DLVL_INFO, "Welcome to Yield OS (rst = %x)\n",
@@ -154,6 +173,10 @@ void Main(void *arg)
     /* print the coredump if prGesent */
     CoreDump_PrintDump(1);
 
+    /* run the benchmarks */
+#if BENCH_ENABLED
+    Bench_Init();
+#endif
     /* start the esp test */
 
 
@@ -0,0 +1,89 @@
+/**
+ * @file sock_hash.h
+ *
+ * @author Tomasz Watorowski (tomasz.watorowski@gmail.com)
+ * @date 2025-05-06
+ *
+ * @brief TCP/IP Stack: hashing used for the socket lookup tables (incoming
+ * frames are matched against sockets by the connection identifier or the
+ * local port)
+ */
+
+#ifndef NET_TCPIP_SOCK_HASH_H
+#define NET_TCPIP_SOCK_HASH_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "compiler.h"
+#include "net/tcpip/ip_addr.h"
+
+/**
+ * @brief get the number of lookup table buckets for given number of sockets:
+ * power of 2 that is at least twice the number of sockets so that the chains
+ * stay short
+ *
+ * @param num number of sockets
+ *
+ * @return size_t number of buckets
+ */
+static inline ALWAYS_INLINE size_t TCPIPSockHash_GetSize(size_t num)
+{
+    /* number of buckets */
+    size_t size = 1;
+    /* find the power of 2 */
+    while (size < 2 * num)
+        size <<= 1;
+    /* return the number of buckets */
+    return size;
+}
+
+/**
+ * @brief mix the bits of the key (multiplicative hashing)
+ *
+ * @param key key value
+ *
+ * @return uint32_t hash value
+ */
+static inline ALWAYS_INLINE uint32_t TCPIPSockHash_Mix(uint32_t key)
+{
+    /* golden ratio multiplier spreads the key, upper bits are folded back
+     * as the bucket index is taken from the lower ones */
+    key *= 0x9e3779b1;
+    return key ^ key >> 16;
+}
+
+/**
+ * @brief get the lookup table bucket for the local port
+ *
+ * @param port local port number
+ * @param size number of buckets (power of 2)
+ *
+ * @return size_t bucket index
+ */
+static inline ALWAYS_INLINE size_t TCPIPSockHash_Port(uint16_t port,
+    size_t size)
+{
+    /* hash the port number */
+    return TCPIPSockHash_Mix(port) & (size - 1);
+}
+
+/**
+ * @brief get the lookup table bucket for the connection identifier
+ *
+ * @param ip remote ip address
+ * @param rem_port remote port number
+ * @param loc_port local port number
+ * @param size number of buckets (power of 2)
+ *
+ * @return size_t bucket index
+ */
+static inline ALWAYS_INLINE size_t TCPIPSockHash_Conn(tcpip_ip_addr_t ip,
+    uint16_t rem_port, uint16_t loc_port, size_t size)
+{
+    /* hash all of the identifier fields */
+    return TCPIPSockHash_Mix(ip.u32 ^
+        TCPIPSockHash_Mix((uint32_t)rem_port << 16 | loc_port)) & (size - 1);
+}
+
+#endif /* NET_TCPIP_SOCK_HASH_H */
@@ -15,7 +15,7 @@
 #include "util/endian.h"
 
 /* calculate checksum */
-uint16_t OPTIMIZE("Os") TCPIPChecksum_Checksum(uint16_t sum, const void *ptr, size_t size)
+uint16_t HOT OPTIMIZE("Os") TCPIPChecksum_Checksum(uint16_t sum, const void *ptr, size_t size)
 {
     /* bytewise pointer */
     const union { uint16_t u16; uint8_t u8[2]; } PACKED *p = ptr;
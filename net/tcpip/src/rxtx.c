@@ -25,40 +25,30 @@
 /* underlying device */
 #include "dev/usb_eem.h"
 
-/* buffer for reception */
-static uint8_t rx_buf[TCPIP_RXTX_BUF_SIZE];
-/* size of tx buffer */
-static int rx_size;
-
-/* transmission buffers */
-static struct tx_buf {
-    /* frame size */
-    size_t size;
-    /* element is allocated */
-    int allocated;
-    /* buffer */
-    uint8_t ALIGNED(4) buf[TCPIP_RXTX_BUF_SIZE];
-} tx_buf[4];
-
 /* reception task for the tcp/ip stack */
 void TCPIPRxTx_RxTask(void *arg)
 {
     /* frame descriptor */
     static tcpip_frame_t frame;
+    /* size of the received frame, frame pointer and the buffer id */
+    err_t rx_size; void *ptr; int id;
     /* infinite loop */
     for (;; Yield()) {
-        /* receive frame from the ethernet interface */
-        rx_size = USBEEM_Recv(rx_buf, sizeof(rx_buf), 0);
+        /* receive frame from the ethernet interface, frame is processed in
+         * place within the interface's reception buffer */
+        rx_size = USBEEM_RecvRx(&ptr, &id, 0);
 
         /* valid reception with no errors? */
         if (rx_size > 0) {
             /* setup frame descriptor */
             frame.flags = 0;
-            frame.bufid = 0;
-            frame.ptr = rx_buf;
+            frame.bufid = id;
+            frame.ptr = ptr;
             frame.size = rx_size;
             /* put the frame on the stack */
             TCPIPEth_Input(&frame);
+            /* protocol handlers are done with it, give the buffer back */
+            USBEEM_ReleaseRx(id);
         /* error during reception */
         } else if (rx_size < 0) {
             TCPIP_Reset();
@@ -66,33 +56,11 @@ void TCPIPRxTx_RxTask(void *arg)
     }
 }
 
-/* sender task */
-void TCPIPRxTx_TxTask(void *arg)
-{
-    /* endless loop */
-    for (;; Yield()) {
-        /* transmission buffer to be sent */
-        struct tx_buf *t;
-
-        /* go through all allocated elements */
-        for (t = tx_buf; t != tx_buf + elems(tx_buf); t++) {
-            /* buffer is unallocated or not filled */
-            if (!t->allocated || !t->size)
-                continue;
-            /* send frame over ethernet interface */
-            USBEEM_Send(t->buf, t->size, 0);
-            /* clear the buffer */
-            t->size = 0; t->allocated = 0;
-        }
-    }
-}
-
 /* initialize underlying physical interface */
 err_t TCPIPRxTx_Init(void)
 {
     /* create reception task didas */
     Yield_Task(TCPIPRxTx_RxTask, 0, 2048);
-    Yield_Task(TCPIPRxTx_TxTask, 0, 1024);
     /* report status */
     return EOK;
 }
@@ -100,22 +68,18 @@ err_t TCPIPRxTx_Init(void)
 /* allocate buffer for sending data */
 err_t TCPIPRxTx_Alloc(tcpip_frame_t *frame)
 {
-    /* transmission buffer to be assigned to the caller */
-    struct tx_buf *t = tx_buf + elems(tx_buf);
+    /* buffer id or error code */
+    err_t id;
 
-    /* loop until free transmission buffer is found */
-    for (; t == tx_buf + elems(tx_buf); Yield()) {
-        /* look for an element that is not occupied */
-        for (t = tx_buf; t != tx_buf + elems(tx_buf) && t->allocated; t++);
-    }
+    /* frame is built directly within the interface's transmission buffer
+     * (waits until one becomes free) */
+    if ((id = USBEEM_AllocTx(&frame->ptr, 0)) < EOK)
+        return id;
 
-    /* mark as occupied */
-    t->allocated = 1;
     /* setup the frame descriptor structure */
     frame->flags = 0;
-    frame->ptr = t->buf;
-    frame->size = sizeof(t->buf);
-    frame->bufid = t - tx_buf;
+    frame->size = USBEEM_MAX_ETH_FRAME_LEN;
+    frame->bufid = id;
 
     /* report success */
     return EOK;
@@ -124,23 +88,21 @@ err_t TCPIPRxTx_Alloc(tcpip_frame_t *frame)
 /* drop the given frame */
 err_t TCPIPRxTx_Drop(tcpip_frame_t *frame)
 {
-    struct tx_buf *t = &tx_buf[frame->bufid];
-    /* clear the buffer */
-    t->size = 0;
-    t->allocated = 0;
-    /* nothing can fail here ;-) */
-    return EOK;
+    /* give the buffer back */
+    return USBEEM_ReleaseTx(frame->bufid);
 }
 
 /* stack's output routine */
 err_t TCPIPRxTx_Send(tcpip_frame_t *frame)
 {
     /* result code */
-    err_t rc = EOK;
+    err_t rc;
 
-    /* mark as ready to be sent */
-    tx_buf[frame->bufid].size = frame->size;
+    /* queue the buffer by reference, our reference is no longer needed
+     * regardless of the outcome */
+    rc = USBEEM_SendTx(frame->bufid, frame->size);
+    USBEEM_ReleaseTx(frame->bufid);
 
     /* return the status code */
-    return rc;
+    return rc < EOK ? rc : EOK;
 }
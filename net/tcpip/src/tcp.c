@@ -35,6 +35,9 @@ err_t TCPIPTcp_Input(tcpip_frame_t *frame)
     
     /* process flags and data offset field */
     int doffs = TCPIPTcpFrame_GetDataOffs(frame->tcp);
+    /* header (with options) must fit within the frame */
+    if (doffs < sizeof(tcpip_tcp_frame_t) || doffs > frame->size)
+        return EMALFORMED;
     /* setup payload pointer and size */
     frame->ptr = (void *)((uintptr_t)frame->ptr + doffs);
     frame->size -= doffs;
@@ -73,14 +76,17 @@ err_t TCPIPTcp_Drop(tcpip_frame_t *frame)
 /* send allocated data */
 err_t TCPIPTcp_Send(tcpip_frame_t *frame, tcpip_ip_addr_t dst_addr, 
     tcpip_tcp_port_t src_port, tcpip_tcp_port_t dst_port,
-    uint32_t seq, uint32_t ack, uint16_t win, tcpip_tcp_flags_t flags)
+    uint32_t seq, uint32_t ack, uint16_t win, tcpip_tcp_flags_t flags,
+    const tcpip_tcp_opts_t *opts)
 {
     /* tcp header pointer */
     tcpip_tcp_frame_t *tcp = frame->tcp;
+    /* options go right after the fixed part of the header */
+    size_t opts_size = opts ? TCPIPTcpOpts_Render(tcp->pld, opts) : 0;
 
     /* setup bitfields */
     TCPIPTcpFrame_SetFlags(tcp, flags);
-    TCPIPTcpFrame_SetDataOffs(tcp, sizeof(*tcp));
+    TCPIPTcpFrame_SetDataOffs(tcp, sizeof(*tcp) + opts_size);
     /* setup ports */
     TCPIPTcpFrame_SetDstPort(tcp, dst_port);
     TCPIPTcpFrame_SetSrcPort(tcp, src_port);
@@ -95,7 +101,7 @@ err_t TCPIPTcp_Send(tcpip_frame_t *frame, tcpip_ip_addr_t dst_addr,
 
     /* prepare for underlying layers */
     frame->ptr = tcp;
-    frame->size += sizeof(tcpip_tcp_frame_t);
+    frame->size += sizeof(tcpip_tcp_frame_t) + opts_size;
 
     /* bombs away! */
     return TCPIPIp_Send(frame, dst_addr, TCPIP_IP_PROTOCOL_TCP);
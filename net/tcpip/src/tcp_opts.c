@@ -0,0 +1,162 @@
+/**
+ * @file tcp_opts.c
+ *
+ * @author Tomasz Watorowski (tomasz.watorowski@gmail.com)
+ * @date 2025-05-02
+ *
+ * @brief TCP/IP Stack: Transmission Control Protocol options
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "err.h"
+#include "net/tcpip/tcp_opts.h"
+#include "util/minmax.h"
+
+/* read big endian values from unaligned locations */
+static uint16_t TCPIPTcpOpts_Rd16(const uint8_t *p)
+{
+    return (uint16_t)p[0] << 8 | p[1];
+}
+
+/* 32-bit version of the above */
+static uint32_t TCPIPTcpOpts_Rd32(const uint8_t *p)
+{
+    return (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 |
+        (uint32_t)p[2] << 8 | p[3];
+}
+
+/* write big endian values to unaligned locations */
+static uint8_t * TCPIPTcpOpts_Wr32(uint8_t *p, uint32_t v)
+{
+    *p++ = v >> 24; *p++ = v >> 16; *p++ = v >> 8; *p++ = v;
+    /* return the pointer to the next byte */
+    return p;
+}
+
+/* parse the options area */
+err_t TCPIPTcpOpts_Parse(const void *ptr, size_t size, tcpip_tcp_opts_t *opts)
+{
+    /* byte-wise pointer to the options */
+    const uint8_t *p8 = ptr;
+
+    /* nothing is present until found */
+    opts->flags = 0;
+    /* go through all the options */
+    for (size_t i = 0; i < size; ) {
+        /* option kind */
+        uint8_t kind = p8[i];
+
+        /* end of the list */
+        if (kind == TCPIP_TCP_OPTS_KIND_END)
+            break;
+        /* single byte padding */
+        if (kind == TCPIP_TCP_OPTS_KIND_NOP) {
+            i++; continue;
+        }
+
+        /* all other options have the length byte that covers the whole
+         * option */
+        if (i + 1 >= size || p8[i + 1] < 2 || i + p8[i + 1] > size)
+            return EMALFORMED;
+        /* option length and the pointer to it's value */
+        uint8_t len = p8[i + 1]; const uint8_t *v = p8 + i + 2;
+
+        /* store the values of known options */
+        switch (kind) {
+        case TCPIP_TCP_OPTS_KIND_MSS: {
+            if (len != 4) break;
+            opts->mss = TCPIPTcpOpts_Rd16(v);
+            opts->flags |= TCPIP_TCP_OPTS_MSS;
+        } break;
+        case TCPIP_TCP_OPTS_KIND_WSCALE: {
+            if (len != 3) break;
+            opts->wscale = min(v[0], TCPIP_TCP_OPTS_WSCALE_MAX);
+            opts->flags |= TCPIP_TCP_OPTS_WSCALE;
+        } break;
+        case TCPIP_TCP_OPTS_KIND_TS: {
+            if (len != 10) break;
+            opts->ts_val = TCPIPTcpOpts_Rd32(v);
+            opts->ts_ecr = TCPIPTcpOpts_Rd32(v + 4);
+            opts->flags |= TCPIP_TCP_OPTS_TS;
+        } break;
+        case TCPIP_TCP_OPTS_KIND_SACK_PERM: {
+            if (len != 2) break;
+            opts->flags |= TCPIP_TCP_OPTS_SACK_PERM;
+        } break;
+        case TCPIP_TCP_OPTS_KIND_SACK: {
+            if ((len - 2) % 8) break;
+            /* store as many blocks as we can hold */
+            opts->sack_num = min((len - 2) / 8, TCPIP_TCP_OPTS_SACK_MAX);
+            for (int j = 0; j < opts->sack_num; j++) {
+                opts->sack[j].start = TCPIPTcpOpts_Rd32(v + j * 8);
+                opts->sack[j].end = TCPIPTcpOpts_Rd32(v + j * 8 + 4);
+            }
+            opts->flags |= TCPIP_TCP_OPTS_SACK;
+        } break;
+        /* unknown option */
+        default: break;
+        }
+
+        /* go to the next option */
+        i += len;
+    }
+
+    /* report status */
+    return EOK;
+}
+
+/* get the size of rendered options */
+size_t TCPIPTcpOpts_GetSize(const tcpip_tcp_opts_t *opts)
+{
+    /* every option is padded to 4 bytes */
+    return (opts->flags & TCPIP_TCP_OPTS_MSS ? 4 : 0) +
+        (opts->flags & TCPIP_TCP_OPTS_WSCALE ? 4 : 0) +
+        (opts->flags & TCPIP_TCP_OPTS_TS ? 12 : 0) +
+        (opts->flags & TCPIP_TCP_OPTS_SACK_PERM ? 4 : 0) +
+        (opts->flags & TCPIP_TCP_OPTS_SACK ? 4 + opts->sack_num * 8 : 0);
+}
+
+/* render the options */
+size_t TCPIPTcpOpts_Render(void *ptr, const tcpip_tcp_opts_t *opts)
+{
+    /* byte-wise pointer to the options */
+    uint8_t *p8 = ptr;
+
+    /* maximal segment size */
+    if (opts->flags & TCPIP_TCP_OPTS_MSS) {
+        *p8++ = TCPIP_TCP_OPTS_KIND_MSS; *p8++ = 4;
+        *p8++ = opts->mss >> 8; *p8++ = opts->mss;
+    }
+    /* window scale (preceded by the nop) */
+    if (opts->flags & TCPIP_TCP_OPTS_WSCALE) {
+        *p8++ = TCPIP_TCP_OPTS_KIND_NOP;
+        *p8++ = TCPIP_TCP_OPTS_KIND_WSCALE; *p8++ = 3;
+        *p8++ = opts->wscale;
+    }
+    /* timestamps (preceded by two nops, as recommended by rfc7323) */
+    if (opts->flags & TCPIP_TCP_OPTS_TS) {
+        *p8++ = TCPIP_TCP_OPTS_KIND_NOP; *p8++ = TCPIP_TCP_OPTS_KIND_NOP;
+        *p8++ = TCPIP_TCP_OPTS_KIND_TS; *p8++ = 10;
+        p8 = TCPIPTcpOpts_Wr32(p8, opts->ts_val);
+        p8 = TCPIPTcpOpts_Wr32(p8, opts->ts_ecr);
+    }
+    /* sack permitted (preceded by two nops) */
+    if (opts->flags & TCPIP_TCP_OPTS_SACK_PERM) {
+        *p8++ = TCPIP_TCP_OPTS_KIND_NOP; *p8++ = TCPIP_TCP_OPTS_KIND_NOP;
+        *p8++ = TCPIP_TCP_OPTS_KIND_SACK_PERM; *p8++ = 2;
+    }
+    /* sack blocks (preceded by two nops) */
+    if (opts->flags & TCPIP_TCP_OPTS_SACK) {
+        *p8++ = TCPIP_TCP_OPTS_KIND_NOP; *p8++ = TCPIP_TCP_OPTS_KIND_NOP;
+        *p8++ = TCPIP_TCP_OPTS_KIND_SACK; *p8++ = 2 + opts->sack_num * 8;
+        for (int i = 0; i < opts->sack_num; i++) {
+            p8 = TCPIPTcpOpts_Wr32(p8, opts->sack[i].start);
+            p8 = TCPIPTcpOpts_Wr32(p8, opts->sack[i].end);
+        }
+    }
+
+    /* return the number of bytes written */
+    return p8 - (uint8_t *)ptr;
+}
@@ -13,11 +13,15 @@
 #include "err.h"
 #include "dev/seed.h"
 #include "net/tcpip/ip_addr.h"
+#include "net/tcpip/sock_hash.h"
 #include "net/tcpip/tcp.h"
+#include "net/tcpip/tcp_opts.h"
 #include "net/tcpip/tcp_sock.h"
 #include "util/elems.h"
+#include "sys/heap.h"
 #include "sys/queue.h"
-#include "sys/sem.h"
+#include "sys/mutex.h"
+#include "sys/sysconf.h"
 #include "sys/time.h"
 #include "sys/yield.h"
 #include "util/elems.h"
@@ -28,10 +32,18 @@
 #define DEBUG DLVL_INFO
 #include "debug.h"
 
-/* sockets */
-static tcpip_tcp_sock_t sockets[TCPIP_TCP_SOCK_NUM];
+/* sockets (table is sized at boot, see sysconf.h) */
+static tcpip_tcp_sock_t *sockets; static size_t sockets_num;
+/* lookup tables for the connections and the listening sockets */
+static tcpip_tcp_sock_t **conn_tbl, **lstn_tbl; static size_t tbl_size;
+/* sockets that need the output processing (in the order of marking) and the
+ * timer queue (ordered by the deadline) */
+static tcpip_tcp_sock_t *dirty, **dirty_tail = &dirty, *timers;
+/* number of connection requests taken by the listening sockets so far (used
+ * for handing the connections over in the order of arrival) */
+static uint32_t arrivals;
 /* processing lock */
-static sem_t lock;
+static mutex_t lock;
 
 #if 0 // TODO: we need to do something about this function :)
 /* sends RST frame in reply to provided frame */
@@ -81,10 +93,303 @@ static err_t TCPIPTcpSock_Reject(tcpip_frame_t *frame)
 
     /* try to send the frame */
     return TCPIPTcp_Send(&response, ip_addr, dst_port, src_port,
-        seq, ack, 0, flags);
+        seq, ack, 0, flags, 0);
 }
 #endif
 
+/* get the smallest window scale that allows to advertise the whole rx
+ * queue */
+static uint8_t TCPIPTcpSock_GetWScale(tcpip_tcp_sock_t *sock)
+{
+    /* size of the reception queue */
+    size_t size = Queue_GetUsed(sock->rxq) + Queue_GetFree(sock->rxq);
+    /* window field is 16 bits wide */
+    uint8_t shift = 0;
+    while (shift < TCPIP_TCP_OPTS_WSCALE_MAX && (size >> shift) > 0xffff)
+        shift++;
+    /* return the shift */
+    return shift;
+}
+
+/* get the reception window that can be advertised, it's granularity depends
+ * on the window scale */
+static uint32_t TCPIPTcpSock_GetRxWin(tcpip_tcp_sock_t *sock)
+{
+    /* limit to what can be expressed with the window field */
+    uint32_t win = min(Queue_GetFree(sock->rxq),
+        (uint32_t)0xffff << sock->rx_wscale);
+    /* round down to the scale granularity */
+    return win >> sock->rx_wscale << sock->rx_wscale;
+}
+
+/* unlink the socket from the lookup table */
+static void TCPIPTcpSock_Unhash(tcpip_tcp_sock_t *sock)
+{
+    /* socket is not linked anywhere */
+    if (!sock->hbucket)
+        return;
+    /* look for the link that points to the socket */
+    for (tcpip_tcp_sock_t **pp = sock->hbucket; *pp; pp = &(*pp)->hnext)
+        if (*pp == sock) {
+            *pp = sock->hnext; break;
+        }
+    /* socket is no longer linked */
+    sock->hnext = 0, sock->hbucket = 0;
+}
+
+/* link the socket into the lookup table bucket */
+static void TCPIPTcpSock_Hash(tcpip_tcp_sock_t *sock,
+    tcpip_tcp_sock_t **bucket)
+{
+    /* socket may be linked within other table */
+    TCPIPTcpSock_Unhash(sock);
+    /* put at the front of the chain */
+    sock->hnext = *bucket, *bucket = sock, sock->hbucket = bucket;
+}
+
+/* put the socket on the list of sockets that need the output processing,
+ * may be called without the lock as nothing here yields */
+static void TCPIPTcpSock_MarkDirty(tcpip_tcp_sock_t *sock)
+{
+    /* socket is already on the list */
+    if (sock->dirty)
+        return;
+    /* append at the end so that sockets are served in order */
+    sock->dirty = 1, sock->dnext = 0;
+    *dirty_tail = sock, dirty_tail = &sock->dnext;
+}
+
+/* remove the socket from the timer queue */
+static void TCPIPTcpSock_Unschedule(tcpip_tcp_sock_t *sock)
+{
+    /* socket is not queued */
+    if (!sock->timed)
+        return;
+    /* look for the link that points to the socket */
+    for (tcpip_tcp_sock_t **pp = &timers; *pp; pp = &(*pp)->tnext)
+        if (*pp == sock) {
+            *pp = sock->tnext; break;
+        }
+    /* socket is no longer queued */
+    sock->tnext = 0, sock->timed = 0;
+}
+
+/* put the socket into the timer queue according to the earliest of it's
+ * timers */
+static void TCPIPTcpSock_Schedule(tcpip_tcp_sock_t *sock)
+{
+    /* timers that are running */
+    time_t ts[3]; int num = 0;
+
+    /* timers are recomputed from scratch */
+    TCPIPTcpSock_Unschedule(sock);
+    /* sockets that do not transmit anything have no timers */
+    if (sock->state <= TCPIP_TCP_SOCK_STATE_LISTEN)
+        return;
+
+    /* retransmission timer runs as long as there is data in flight */
+    if (sock->tx_seq_end != sock->tx_seq_start)
+        ts[num++] = sock->tx_retr_ts + sock->tx_rto;
+    /* delayed ack */
+    if (sock->rx_seq_recvd != sock->rx_seq_acked)
+        ts[num++] = sock->rx_ack_ts + TCPIP_TCP_ACK_DELAY;
+    /* remote site does not close it's side of the connection */
+    if (sock->state == TCPIP_TCP_SOCK_STATE_CLOSING &&
+        sock->tx_seq_end == sock->tx_seq_start)
+        ts[num++] = sock->syn_fin_ts + TCPIP_TCP_FIN_WAIT_TIMEOUT + 1;
+    /* nothing to wait for */
+    if (!num)
+        return;
+
+    /* pick the earliest one */
+    sock->deadline = ts[0];
+    for (int i = 1; i < num; i++)
+        if (dtime(ts[i], sock->deadline) < 0)
+            sock->deadline = ts[i];
+    /* insert keeping the queue ordered */
+    tcpip_tcp_sock_t **pp = &timers;
+    while (*pp && dtime((*pp)->deadline, sock->deadline) <= 0)
+        pp = &(*pp)->tnext;
+    sock->tnext = *pp, *pp = sock, sock->timed = 1;
+}
+
+/* find the socket that the incoming frame is directed to */
+static tcpip_tcp_sock_t * TCPIPTcpSock_Lookup(tcpip_ip_addr_t ip,
+    tcpip_tcp_port_t src_port, tcpip_tcp_port_t dst_port)
+{
+    /* socket pointer */
+    tcpip_tcp_sock_t *sock;
+
+    /* connections go first, closed sockets are unlinked lazily (when they
+     * get reused) so the state needs to be checked */
+    for (sock = conn_tbl[TCPIPSockHash_Conn(ip, src_port, dst_port,
+        tbl_size)]; sock; sock = sock->hnext)
+        if (sock->state > TCPIP_TCP_SOCK_STATE_LISTEN &&
+            sock->loc_port == dst_port && sock->rem_port == src_port &&
+            TCPIPIpAddr_AddressMatch(ip, sock->addr))
+            return sock;
+    /* then the sockets that wait for connections */
+    for (sock = lstn_tbl[TCPIPSockHash_Port(dst_port, tbl_size)]; sock;
+        sock = sock->hnext)
+        if (sock->state == TCPIP_TCP_SOCK_STATE_LISTEN &&
+            sock->loc_port == dst_port)
+            return sock;
+
+    /* nobody is interested */
+    return 0;
+}
+
+/* reset the socket state so that it can accept the connection on given
+ * port */
+static void TCPIPTcpSock_PrepareListen(tcpip_tcp_sock_t *sock,
+    tcpip_tcp_port_t port)
+{
+    /* reset control flags */
+    sock->tx_flags = sock->rx_flags = 0;
+    /* options that we are willing to use */
+    sock->opts = TCPIP_TCP_OPTS_WSCALE | TCPIP_TCP_OPTS_TS |
+        TCPIP_TCP_OPTS_SACK_PERM;
+    /* setup the port number and advance to listen state */
+    sock->loc_port = port;
+    sock->state = TCPIP_TCP_SOCK_STATE_LISTEN;
+    /* close both sides of the link */
+    sock->loc_link = TCPIP_TCP_LINK_STATE_CLOSED;
+    sock->rem_link = TCPIP_TCP_LINK_STATE_CLOSED;
+
+    /* clear the queues */
+    Queue_Drop(sock->rxq, Queue_GetUsed(sock->rxq));
+    Queue_Drop(sock->txq, Queue_GetUsed(sock->txq));
+}
+
+/* get the socket from the listening socket's pool that will take the new
+ * connection */
+static tcpip_tcp_sock_t * TCPIPTcpSock_GetChild(tcpip_tcp_sock_t *sock)
+{
+    /* socket pointer */
+    tcpip_tcp_sock_t *child;
+
+    /* look for the pool socket that is not in use (this happens only for
+     * the connection requests) */
+    for (child = sockets; child != sockets + sockets_num; child++)
+        if (child->parent == sock && !child->accepted &&
+            child->state == TCPIP_TCP_SOCK_STATE_CLOSED)
+            break;
+    /* backlog is full */
+    if (child == sockets + sockets_num)
+        return 0;
+
+    /* inherit the settings */
+    child->tx_nodelay = sock->tx_nodelay;
+    /* child is now waiting for the connection */
+    TCPIPTcpSock_PrepareListen(child, sock->loc_port);
+    /* return the socket */
+    return child;
+}
+
+/* check if the ack for the received data shall be sent now */
+static int TCPIPTcpSock_IsAckDue(tcpip_tcp_sock_t *sock)
+{
+    /* everything was acked already */
+    if (sock->rx_seq_recvd == sock->rx_seq_acked)
+        return 0;
+    /* enough segments were received or the delay has elapsed */
+    return sock->rx_ack_cnt >= TCPIP_TCP_ACK_SEGS ||
+        dtime_now(sock->rx_ack_ts) >= TCPIP_TCP_ACK_DELAY;
+}
+
+/* check if the window update shall be sent: right edge of the window must
+ * move by a significant amount (receiver side silly window avoidance) */
+static int TCPIPTcpSock_IsWinUpdateDue(tcpip_tcp_sock_t *sock)
+{
+    /* size of the reception queue */
+    size_t size = Queue_GetUsed(sock->rxq) + Queue_GetFree(sock->rxq);
+    /* how far the right edge moved since it was last advertised */
+    int32_t grow = (sock->rx_seq_recvd + TCPIPTcpSock_GetRxWin(sock)) -
+        (sock->rx_seq_acked + sock->rx_win);
+
+    /* two full segments or half of the queue, whichever is smaller */
+    return grow > 0 && grow >= (int32_t)min(2 * TCPIP_TCP_MSS, size / 2);
+}
+
+/* reset the round trip time estimator */
+static void TCPIPTcpSock_ResetRtt(tcpip_tcp_sock_t *sock)
+{
+    /* nothing measured, initial timeout is used */
+    sock->tx_srtt = sock->tx_rttvar = 0, sock->tx_rtt_on = 0;
+    sock->tx_rto = TCPIP_TCP_RTO;
+}
+
+/* update the round trip time estimate with the new measurement (rfc6298) */
+static void TCPIPTcpSock_UpdateRtt(tcpip_tcp_sock_t *sock, dtime_t rtt)
+{
+    /* measurement cannot be finer than the clock granularity */
+    rtt = max(rtt, 1);
+
+    /* first measurement */
+    if (!sock->tx_srtt) {
+        sock->tx_srtt = rtt << 3, sock->tx_rttvar = rtt << 1;
+    /* srtt = 7/8 srtt + 1/8 rtt, rttvar = 3/4 rttvar + 1/4 |srtt - rtt| */
+    } else {
+        int32_t delta = rtt - (sock->tx_srtt >> 3);
+        sock->tx_srtt += delta;
+        sock->tx_rttvar += (delta < 0 ? -delta : delta) -
+            (sock->tx_rttvar >> 2);
+    }
+
+    /* rto = srtt + 4 * rttvar, new measurement cancels the back-off */
+    sock->tx_rto = min(max((sock->tx_srtt >> 3) + sock->tx_rttvar,
+        TCPIP_TCP_RTO_MIN), TCPIP_TCP_RTO_MAX);
+}
+
+/* remember the range of sequence numbers that was received out of order */
+static void TCPIPTcpSock_AddOoo(tcpip_tcp_sock_t *sock, uint32_t start,
+    uint32_t end)
+{
+    /* absorb all the ranges that overlap or touch the new one */
+    for (int i = 0; i < sock->rx_ooo_num; ) {
+        /* disjoint range */
+        if ((int32_t)(sock->rx_ooo[i].start - end) > 0 ||
+            (int32_t)(start - sock->rx_ooo[i].end) > 0) {
+            i++; continue;
+        }
+        /* extend the new range */
+        if ((int32_t)(sock->rx_ooo[i].start - start) < 0)
+            start = sock->rx_ooo[i].start;
+        if ((int32_t)(sock->rx_ooo[i].end - end) > 0)
+            end = sock->rx_ooo[i].end;
+        /* remove the old one */
+        memmove(&sock->rx_ooo[i], &sock->rx_ooo[i + 1],
+            (--sock->rx_ooo_num - i) * sizeof(sock->rx_ooo[0]));
+    }
+
+    /* most recent range goes first, the oldest one is forgotten when there is
+     * no space left (it's data will simply be retransmitted) */
+    sock->rx_ooo_num = min(sock->rx_ooo_num + 1, TCPIP_TCP_OOO_NUM);
+    memmove(&sock->rx_ooo[1], &sock->rx_ooo[0],
+        (sock->rx_ooo_num - 1) * sizeof(sock->rx_ooo[0]));
+    sock->rx_ooo[0].start = start, sock->rx_ooo[0].end = end;
+}
+
+/* append the data that was received out of order and became contiguous with
+ * what was received in order */
+static void TCPIPTcpSock_MergeOoo(tcpip_tcp_sock_t *sock)
+{
+    /* ranges are disjoint so that a single pass is enough */
+    for (int i = 0; i < sock->rx_ooo_num; ) {
+        /* there is still a gap before this range */
+        if ((int32_t)(sock->rx_ooo[i].start - sock->rx_seq_recvd) > 0) {
+            i++; continue;
+        }
+        /* data is already in place, right after the rxq head */
+        if ((int32_t)(sock->rx_ooo[i].end - sock->rx_seq_recvd) > 0)
+            sock->rx_seq_recvd += Queue_Commit(sock->rxq,
+                sock->rx_ooo[i].end - sock->rx_seq_recvd);
+        /* range is no longer needed */
+        memmove(&sock->rx_ooo[i], &sock->rx_ooo[i + 1],
+            (--sock->rx_ooo_num - i) * sizeof(sock->rx_ooo[0]));
+    }
+}
+
 /* process incoming frames */
 static err_t TCPIPTcpSock_ProcessIncoming(tcpip_frame_t *frame,
     tcpip_tcp_sock_t *sock)
@@ -122,6 +427,13 @@ static err_t TCPIPTcpSock_ProcessIncoming(tcpip_frame_t *frame,
     uint32_t win = TCPIPTcpFrame_GetWindow(tcp);
     /* extract flags */
     tcpip_tcp_flags_t rx_flags = TCPIPTcpFrame_GetFlags(tcp);
+    /* parse the options */
+    tcpip_tcp_opts_t opts;
+    /* segment lies beyond the next sequence number that we expect */
+    int ahead = 0;
+    if (TCPIPTcpOpts_Parse(tcp->pld, TCPIPTcpFrame_GetDataOffs(tcp) -
+        sizeof(*tcp), &opts) != EOK)
+        goto error;
 
     /* reset segment with matching flags */
     if (rx_flags & TCPIP_TCP_FLAGS_RST) {
@@ -141,14 +453,31 @@ static err_t TCPIPTcpSock_ProcessIncoming(tcpip_frame_t *frame,
         /* handle the initialization of the counters */
         /* store the credentials */
         sock->addr = ip, sock->rem_port = src_port;
+        /* from now on the socket is looked up by the connection
+         * identifier */
+        if (sock->state == TCPIP_TCP_SOCK_STATE_LISTEN)
+            TCPIPTcpSock_Hash(sock, &conn_tbl[TCPIPSockHash_Conn(ip,
+                src_port, sock->loc_port, tbl_size)]);
         /* along with the syn segment connection initiator sends it's
         * sequencing numbers */
         sock->rx_seq_recvd = seq + 1;
         sock->rx_seq_acked = seq;
+        /* nothing was received out of order yet */
+        sock->rx_ooo_num = 0;
+        /* syn is acked at once */
+        sock->rx_ack_cnt = TCPIP_TCP_ACK_SEGS;
         /* now we allow full window to be used */
         sock->rx_win = Queue_GetFree(sock->rxq);
-        /* this is a perfect spot to initiate our sequence numbers */
-        sock->tx_seq_start = Seed_GetRand();
+        /* this is a perfect spot to initiate our sequence numbers (locally
+         * initiated connections already have them set up) */
+        if (sock->state == TCPIP_TCP_SOCK_STATE_LISTEN) {
+            sock->tx_seq_start = Seed_GetRand();
+            sock->tx_seq_next = sock->tx_seq_end = sock->tx_seq_start;
+            /* scale that we will offer in syn+ack */
+            sock->rx_wscale = TCPIPTcpSock_GetWScale(sock);
+            /* new connection, nothing is known about the path */
+            TCPIPTcpSock_ResetRtt(sock);
+        }
         sock->tx_win = win;
         /* reset retransmission stuff */
         sock->tx_retr_cnt = 0;
@@ -157,6 +486,8 @@ static err_t TCPIPTcpSock_ProcessIncoming(tcpip_frame_t *frame,
         /* remote-site initiated connection  */
         if (sock->state == TCPIP_TCP_SOCK_STATE_LISTEN) {
             sock->state = TCPIP_TCP_SOCK_STATE_ESTABLISHING;
+            /* stamp the arrival, syn_fin_ts gets overwritten by the fin */
+            sock->arrival = arrivals++;
         /* local site initiated connection */
         } else {
             sock->state = TCPIP_TCP_SOCK_STATE_ESTABLISHED;
@@ -167,8 +498,34 @@ static err_t TCPIPTcpSock_ProcessIncoming(tcpip_frame_t *frame,
 
         /* store the timestamp of the frame received */
         sock->syn_fin_ts = time(0);
+
+        /* remote site's maximal segment size (rfc9293 default when not
+         * given) */
+        sock->tx_mss = opts.flags & TCPIP_TCP_OPTS_MSS ?
+            min(opts.mss, TCPIP_TCP_MSS) : 536;
+        /* window scaling and timestamps are only used when both sites
+         * offer them */
+        sock->opts &= opts.flags & (TCPIP_TCP_OPTS_WSCALE | TCPIP_TCP_OPTS_TS |
+            TCPIP_TCP_OPTS_SACK_PERM);
+        /* set up the scaling */
+        if (sock->opts & TCPIP_TCP_OPTS_WSCALE) {
+            sock->tx_wscale = opts.wscale;
+        } else {
+            sock->tx_wscale = sock->rx_wscale = 0;
+        }
+        /* window advertised with the syn shall not exceed the window field */
+        sock->rx_win = min(sock->rx_win, 0xffff);
     }
 
+    /* windows in segments other than syn are scaled */
+    if (!(rx_flags & TCPIP_TCP_FLAGS_SYN))
+        win <<= sock->tx_wscale;
+    /* remember the timestamp to be echoed, only the segments that start
+     * where we expect them to are taken into account (rfc7323) */
+    if ((sock->opts & opts.flags & TCPIP_TCP_OPTS_TS) &&
+        ((rx_flags & TCPIP_TCP_FLAGS_SYN) || seq == sock->rx_seq_recvd))
+        sock->ts_recent = opts.ts_val;
+
     /* ack frame: remote site wants to ack out data */
     if (rx_flags & TCPIP_TCP_FLAGS_ACK) {
         /* special flags move the sequencing numbers by one w.r.t data */
@@ -179,8 +536,8 @@ static err_t TCPIPTcpSock_ProcessIncoming(tcpip_frame_t *frame,
             sock->state == TCPIP_TCP_SOCK_STATE_LISTEN)
             goto error;
 
-        /* check the ack counters */
-        if (ack - sock->tx_seq_start > sock->tx_seq_end - sock->tx_seq_start)
+        /* acknowledges something that we did not send */
+        if ((int32_t)(ack - sock->tx_seq_end) > 0)
             goto error;
 
         /* if this is a first ack after the out syn+ack then */
@@ -193,8 +550,44 @@ static err_t TCPIPTcpSock_ProcessIncoming(tcpip_frame_t *frame,
             sock->rem_link = TCPIP_TCP_LINK_STATE_OPEN;
         }
 
+        /* handle acknowledgement for outgoing data, acks older than the
+         * oldest unacknowledged sequence number carry no information */
+        size_t b_acked = (int32_t)(ack - sock->tx_seq_start) > 0 ?
+            ack - sock->tx_seq_start : 0;
+        /* fin occupies the sequence number that follows all of the data */
+        int fin_acked = sock->loc_link == TCPIP_TCP_LINK_STATE_CLOSING &&
+            b_acked > Queue_GetUsed(sock->txq);
+        /* drop the data from the queue */
+        Queue_Drop(sock->txq, b_acked);
+        /* move the sequence numbers */
+        sock->tx_seq_start += b_acked;
+        /* data that was scheduled for retransmission got acked already */
+        if ((int32_t)(sock->tx_seq_next - sock->tx_seq_start) < 0)
+            sock->tx_seq_next = sock->tx_seq_start;
+        /* window information is only valid for the acks that are not
+         * older than what we already know */
+        if ((int32_t)(ack - sock->tx_seq_start) >= 0)
+            sock->tx_win = win;
+        /* round trip time measurement: timestamps echo the transmission
+         * time of the segment being acked, otherwise a single segment that
+         * was never retransmitted is timed (karn's algorithm) */
+        if (b_acked && (sock->opts & opts.flags & TCPIP_TCP_OPTS_TS)) {
+            TCPIPTcpSock_UpdateRtt(sock, dtime(time(0), opts.ts_ecr));
+        } else if (sock->tx_rtt_on &&
+            (int32_t)(ack - sock->tx_rtt_seq) > 0) {
+            TCPIPTcpSock_UpdateRtt(sock, dtime(time(0), sock->tx_rtt_ts));
+            sock->tx_rtt_on = 0;
+        }
+        /* stop the retransmission timer when all was acked, restart it when
+         * there is progress */
+        if (sock->tx_seq_start == sock->tx_seq_end) {
+            sock->tx_retr_cnt = 0;
+        } else if (b_acked) {
+            sock->tx_retr_cnt = 1, sock->tx_retr_ts = time(0);
+        }
+
         /* last ack from the remote site? */
-        if (sock->loc_link == TCPIP_TCP_LINK_STATE_CLOSING) {
+        if (fin_acked) {
             sock->loc_link = TCPIP_TCP_LINK_STATE_CLOSED;
             /* remote link was closed previously */
             if (sock->rem_link == TCPIP_TCP_LINK_STATE_CLOSED)
@@ -202,8 +595,18 @@ static err_t TCPIPTcpSock_ProcessIncoming(tcpip_frame_t *frame,
         }
 
         /* handle incoming data */
-        /* only append data if it's in sequence */
-        if (seq == sock->rx_seq_recvd) {
+        /* distance between the segment and what we expect */
+        int32_t offs = seq - sock->rx_seq_recvd;
+        /* retransmission that carries some new data as well: skip the part
+         * that we already have */
+        if (offs < 0 && !(rx_flags & TCPIP_TCP_FLAGS_SYN) &&
+            (size_t)-offs < frame->size) {
+            frame->ptr = (uint8_t *)frame->ptr - offs;
+            frame->size += offs, offs = 0;
+        }
+
+        /* append data that is in sequence */
+        if (offs == 0) {
             /* special flags increment the sequence received */
             if (rx_flags & sf)
                 sock->rx_seq_recvd += 1;
@@ -211,26 +614,42 @@ static err_t TCPIPTcpSock_ProcessIncoming(tcpip_frame_t *frame,
             size_t b_stored = Queue_Put(sock->rxq, frame->ptr, frame->size);
             /* update the sequence number according to accepted data size */
             sock->rx_seq_recvd = sock->rx_seq_recvd + b_stored;
+            /* ack for the data can be delayed, start the timer with the
+             * first segment */
+            if (b_stored && !sock->rx_ack_cnt++)
+                sock->rx_ack_ts = time(0);
+            /* special flags and the data that did not fit are acked at
+             * once */
+            if ((rx_flags & sf) || b_stored < frame->size)
+                sock->rx_ack_cnt = TCPIP_TCP_ACK_SEGS;
+            /* gap before the data received out of order may got filled,
+             * remote site needs to know at once */
+            if (sock->rx_ooo_num) {
+                TCPIPTcpSock_MergeOoo(sock);
+                sock->rx_ack_cnt = TCPIP_TCP_ACK_SEGS;
+            }
+        /* some segment before this one got lost or reordered: keep the data
+         * in the rxq free space at it's final position */
+        } else if (offs > 0) {
+            size_t b_stored = Queue_PutAt(sock->rxq, offs, frame->ptr,
+                frame->size);
+            /* remember what we have */
+            if (b_stored)
+                TCPIPTcpSock_AddOoo(sock, seq, seq + b_stored);
+            /* duplicate ack tells the remote site where the gap starts */
+            sock->rx_seq_acked = seq, ahead = 1;
+            sock->rx_ack_cnt = TCPIP_TCP_ACK_SEGS;
         /* remote site may have not received our last ack to what it sent */
         } else {
             /* this shall cause the re-acking */
             sock->rx_seq_acked = seq;
+            sock->rx_ack_cnt = TCPIP_TCP_ACK_SEGS;
         }
-
-        /* handle acknowledgement for outgoing data */
-        /* let's see how many bytes are acknowledged */
-        size_t b_acked = ack - sock->tx_seq_start;
-        /* drop the data from the queue */
-        Queue_Drop(sock->txq, b_acked);
-        /* move the sequence numbers */
-        sock->tx_seq_start += b_acked;
-        /* reset the retransmission counter when all was acked */
-        if (sock->tx_seq_start == sock->tx_seq_end)
-            sock->tx_retr_cnt = 0;
     }
 
-    /* remote party wants to finalize the connection */
-    if (rx_flags & TCPIP_TCP_FLAGS_FIN) {
+    /* remote party wants to finalize the connection (fin that arrives out of
+     * order will be retransmitted after the gap is filled) */
+    if ((rx_flags & TCPIP_TCP_FLAGS_FIN) && !ahead) {
         /* indicate that the remote link is closing. it will be closed after
          * we respond with ack to this fin */
         sock->state = TCPIP_TCP_SOCK_STATE_CLOSING;
@@ -254,8 +673,10 @@ static err_t TCPIPTcpSock_ProcessIncoming(tcpip_frame_t *frame,
 }
 
 /* process outgoing traffic */
-static void TCPIPTcpSock_ProcessOutgoing(tcpip_tcp_sock_t *sock)
+static err_t TCPIPTcpSock_ProcessOutgoing(tcpip_tcp_sock_t *sock)
 {
+    /* error code */
+    err_t ec = EOK;
     /* frame buffer */
     tcpip_frame_t frame;
     /* flags that we are about to transmit */
@@ -290,100 +711,228 @@ static void TCPIPTcpSock_ProcessOutgoing(tcpip_tcp_sock_t *sock)
     } break;
     }
 
-    /* protect from syn floods and fin stalls */
-    switch (sock->state) {
-    /* these two states are the most sensitive ones */
-    case TCPIP_TCP_SOCK_STATE_ESTABLISHING:
-    case TCPIP_TCP_SOCK_STATE_CLOSING:
-        if (dtime(time(0), sock->syn_fin_ts) > 2000) {
+    /* protect from fin stalls: everything that we've sent was acked but the
+     * remote site does not close it's side of the connection */
+    if (sock->state == TCPIP_TCP_SOCK_STATE_CLOSING &&
+        sock->tx_seq_end == sock->tx_seq_start &&
+        dtime(time(0), sock->syn_fin_ts) > TCPIP_TCP_FIN_WAIT_TIMEOUT) {
+        sock->state = TCPIP_TCP_SOCK_STATE_CLOSED; goto end;
+    }
+
+    /* retransmission timeout: the oldest unacknowledged segment was not
+     * acked in time, go back and send everything again starting from it */
+    if (sock->tx_seq_end != sock->tx_seq_start &&
+        dtime(time(0), sock->tx_retr_ts) >= (dtime_t)sock->tx_rto) {
+        /* protect from syn floods and fin stalls: these two states are the
+         * most sensitive ones */
+        if ((sock->state == TCPIP_TCP_SOCK_STATE_ESTABLISHING ||
+            sock->state == TCPIP_TCP_SOCK_STATE_CLOSING) &&
+            sock->tx_retr_cnt >= TCPIP_TCP_RETR_MAX) {
             sock->state = TCPIP_TCP_SOCK_STATE_CLOSED; goto end;
         }
-    default: break;
+        sock->tx_seq_next = sock->tx_seq_start;
+        sock->tx_retr_cnt += 1, sock->tx_retr_ts = time(0);
+        /* exponential back-off, ongoing measurement is void since we won't
+         * know which of the transmissions gets acked */
+        sock->tx_rto = min(sock->tx_rto * 2, TCPIP_TCP_RTO_MAX);
+        sock->tx_rtt_on = 0;
     }
 
-    /* no special flags, no need to ack anything, no data to sent, no
-     * changes in rx window */
-    if ((tx_flags & (TCPIP_TCP_FLAGS_SYN | TCPIP_TCP_FLAGS_FIN)) == 0 &&
-        sock->rx_seq_recvd == sock->rx_seq_acked &&
-        Queue_GetUsed(sock->txq) == 0 &&
-        Queue_GetFree(sock->rxq) == sock->rx_win)
-        goto end;
-
-    /* check if enough time has passed since last retransmission */
-    if ((dtime(time(0), sock->tx_retr_ts) < 300 * sock->tx_retr_cnt))
-        goto end;
-    /* allocate space for frame to be sent */
-    if (TCPIPTcp_Alloc(&frame) != EOK)
-        goto end;
-
-    /* copy data to the frame payload section */
-    frame.size = Queue_Peek(sock->txq, frame.ptr, frame.size);
-    /* ensure that the data is pushed to the application on the remote site */
-    if (frame.size > 0)
-        tx_flags |= TCPIP_TCP_FLAGS_PSH;
-    /* prepare the sequencing number denoting the end of the message */
-    sock->tx_seq_end = sock->tx_seq_start + frame.size;
-    /* are we sending any of the special flags? */
-    if (tx_flags & (TCPIP_TCP_FLAGS_SYN | TCPIP_TCP_FLAGS_FIN))
-        sock->tx_seq_end += 1;
-
-    /* build up the frame fields */
-    uint32_t seq = sock->tx_seq_start;
-    uint32_t ack = sock->rx_seq_recvd;
-    uint16_t win = Queue_GetFree(sock->rxq);
-
-    /* try to send the frame */
-    if (TCPIPTcp_Send(&frame, sock->addr, sock->loc_port,
-        sock->rem_port, seq, ack, win, tx_flags) < EOK) {
-        dprintf_i("noo\n", 0);
-        goto end;
-    }
+    /* send as many segments as the remote's window allows for */
+    for (int sent = 0;; sent++) {
+        /* flags for this segment */
+        tcpip_tcp_flags_t flags = tx_flags;
+        /* amount of data in the txq, offset of the next byte to be sent
+         * within the txq (sequence numbers in flight) */
+        size_t used = Queue_GetUsed(sock->txq);
+        size_t offs = sock->tx_seq_next - sock->tx_seq_start;
+        /* data that was not sent yet */
+        size_t unsent = offs < used ? used - offs : 0;
+        /* space left in the remote's window */
+        size_t win_left = sock->tx_win > offs ? sock->tx_win - offs : 0;
+
+        /* syn is sent as the first sequence number, no data goes with it */
+        if (flags & TCPIP_TCP_FLAGS_SYN) {
+            if (offs) flags &= ~TCPIP_TCP_FLAGS_SYN;
+            unsent = 0;
+        }
+        /* timestamps go with every segment once negotiated, syn carries
+         * all the options that we offer */
+        tcpip_tcp_opts_t opts = { .flags = sock->opts & TCPIP_TCP_OPTS_TS,
+            .ts_val = time(0), .ts_ecr = sock->ts_recent };
+        if (flags & TCPIP_TCP_FLAGS_SYN) {
+            opts.flags = sock->opts | TCPIP_TCP_OPTS_MSS;
+            opts.mss = TCPIP_TCP_MSS, opts.wscale = sock->rx_wscale;
+        /* report the data that we hold out of order */
+        } else if ((sock->opts & TCPIP_TCP_OPTS_SACK_PERM) &&
+            sock->rx_ooo_num) {
+            opts.flags |= TCPIP_TCP_OPTS_SACK;
+            opts.sack_num = min(sock->rx_ooo_num, TCPIP_TCP_OPTS_SACK_MAX);
+            for (int i = 0; i < opts.sack_num; i++)
+                opts.sack[i].start = sock->rx_ooo[i].start,
+                opts.sack[i].end = sock->rx_ooo[i].end;
+        }
+        /* options take space from the segment */
+        size_t opts_size = TCPIPTcpOpts_GetSize(&opts);
+        /* window is closed and nothing is in flight: probe with a single
+         * byte, retransmission timer will repeat the probe */
+        if (!win_left && !offs && unsent)
+            win_left = 1;
+        /* amount of data to be sent in this segment */
+        size_t size = min(min(unsent, win_left), sock->tx_mss - opts_size);
+        /* fin goes after all the data and is sent only once (unless
+         * retransmitted) */
+        if ((flags & TCPIP_TCP_FLAGS_FIN) && (offs > used || size < unsent))
+            flags &= ~TCPIP_TCP_FLAGS_FIN;
+        /* small segment with new data waits for the data sent before to be
+         * acked so that small writes get coalesced (nagle's algorithm),
+         * the last one before fin goes at once */
+        if (size && size < sock->tx_mss - opts_size && !sock->tx_nodelay &&
+            !(flags & TCPIP_TCP_FLAGS_FIN) &&
+            sock->tx_seq_next == sock->tx_seq_end &&
+            sock->tx_seq_end != sock->tx_seq_start)
+            size = 0;
+
+        /* no special flags, no ack that cannot wait any longer, no data to
+         * sent, no significant changes in rx window. after the first segment
+         * only the data is a reason to send anything */
+        if (!size && (sent || ((flags & (TCPIP_TCP_FLAGS_SYN |
+            TCPIP_TCP_FLAGS_FIN)) == 0 &&
+            !TCPIPTcpSock_IsAckDue(sock) &&
+            !TCPIPTcpSock_IsWinUpdateDue(sock))))
+            break;
 
-    /* store tx flags that were emitted */
-    sock->tx_flags = tx_flags;
-    /* store the window size that was emmited */
-    sock->rx_win = win;
-    /* if the send was successful then we can move the rx ack numbers */
-    sock->rx_seq_acked = sock->rx_seq_recvd;
-    /* frame that was sent had payload besides the ack. if that's the case then
-     * prepare the variables for retransmission if it's needed */
-    if (sock->tx_seq_end != sock->tx_seq_start)
-        sock->tx_retr_cnt += 1, sock->tx_retr_ts = time(0);
+        /* allocate space for frame to be sent */
+        if (TCPIPTcp_Alloc(&frame) != EOK) {
+            ec = EBUSY; break;
+        }
+        /* payload goes after the options */
+        frame.ptr = (uint8_t *)frame.ptr + opts_size; frame.size -= opts_size;
+        /* copy data to the frame payload section */
+        frame.size = Queue_PeekAt(sock->txq, offs, frame.ptr,
+            min(size, frame.size));
+        /* frame could not fit all the data that remains */
+        if (frame.size < unsent)
+            flags &= ~TCPIP_TCP_FLAGS_FIN;
+        /* ensure that the data is pushed to the application on the remote
+         * site */
+        if (frame.size > 0)
+            flags |= TCPIP_TCP_FLAGS_PSH;
+
+        /* build up the frame fields */
+        uint32_t seq = sock->tx_seq_next;
+        uint32_t ack = sock->rx_seq_recvd;
+        /* window is never scaled in syn segments */
+        uint32_t rx_win = flags & TCPIP_TCP_FLAGS_SYN ?
+            min(Queue_GetFree(sock->rxq), 0xffff) : TCPIPTcpSock_GetRxWin(sock);
+        uint16_t win = flags & TCPIP_TCP_FLAGS_SYN ? rx_win :
+            rx_win >> sock->rx_wscale;
+
+        /* try to send the frame */
+        if (TCPIPTcp_Send(&frame, sock->addr, sock->loc_port,
+            sock->rem_port, seq, ack, win, flags,
+            opts.flags ? &opts : 0) < EOK) {
+            dprintf_i("noo\n", 0);
+            ec = EBUSY; break;
+        }
 
-    /* after we sent the ack to remote's fin we can close the remote link */
-    if (sock->rem_link == TCPIP_TCP_LINK_STATE_CLOSING) {
-        sock->rem_link = TCPIP_TCP_LINK_STATE_CLOSED;
-        /* local link was already closed? it that's the case then remote link
-         * closing was the last frame to be received and we can close the
-         * entire socket */
-        if (sock->loc_link == TCPIP_TCP_LINK_STATE_CLOSED)
-            sock->state = TCPIP_TCP_SOCK_STATE_CLOSED;
+        /* advance the sequence number by the data and special flags */
+        sock->tx_seq_next += frame.size +
+            !!(flags & (TCPIP_TCP_FLAGS_SYN | TCPIP_TCP_FLAGS_FIN));
+        /* we've sent something new */
+        if ((int32_t)(sock->tx_seq_next - sock->tx_seq_end) > 0) {
+            /* time it if no other measurement is in progress, segments that
+             * start with retransmitted data are not timed */
+            if (!sock->tx_rtt_on && seq == sock->tx_seq_end)
+                sock->tx_rtt_on = 1, sock->tx_rtt_seq = seq,
+                sock->tx_rtt_ts = time(0);
+            sock->tx_seq_end = sock->tx_seq_next;
+        }
+        /* start the retransmission timer if it was not running */
+        if (sock->tx_seq_end != sock->tx_seq_start && !sock->tx_retr_cnt)
+            sock->tx_retr_cnt = 1, sock->tx_retr_ts = time(0);
+
+        /* store tx flags that were emitted */
+        sock->tx_flags = flags;
+        /* store the window size that was emmited */
+        sock->rx_win = rx_win;
+        /* if the send was successful then we can move the rx ack numbers,
+         * the delayed ack went along with this segment */
+        sock->rx_seq_acked = sock->rx_seq_recvd, sock->rx_ack_cnt = 0;
+
+        /* after we sent the ack to remote's fin we can close the remote
+         * link */
+        if (sock->rem_link == TCPIP_TCP_LINK_STATE_CLOSING) {
+            sock->rem_link = TCPIP_TCP_LINK_STATE_CLOSED;
+            /* local link was already closed? it that's the case then remote
+             * link closing was the last frame to be received and we can
+             * close the entire socket */
+            if (sock->loc_link == TCPIP_TCP_LINK_STATE_CLOSED) {
+                sock->state = TCPIP_TCP_SOCK_STATE_CLOSED; break;
+            }
+        }
     }
 
     /* end of processing */
-    end: return;
+    end: return ec;
 }
 
 /* socket fsm task task */
 static void TCPIPTcpSock_Output(void *arg)
 {
-    /* tcp socket that is being processed */
-    tcpip_tcp_sock_t *sock;
-    /* processing for every socket */
+    /* tcp socket that is being processed, list of sockets to be processed */
+    tcpip_tcp_sock_t *sock, *list;
+    /* processing for the sockets that have work pending */
     for (;; Yield()) {
+        /* nothing was marked and no timer has expired */
+        if (!dirty && (!timers || dtime_now(timers->deadline) < 0))
+            continue;
+
         /* lock the socket access */
-        Sem_Lock(&lock, 0);
-        /* process all the sockets */
-        for (sock = sockets; sock != sockets + elems(sockets); sock++)
-            TCPIPTcpSock_ProcessOutgoing(sock);
+        Mutex_Lock(&lock, 0);
+        /* sockets with expired timers need processing */
+        while (timers && dtime_now(timers->deadline) >= 0) {
+            sock = timers, timers = sock->tnext;
+            sock->tnext = 0, sock->timed = 0;
+            TCPIPTcpSock_MarkDirty(sock);
+        }
+        /* take over the list, sockets that get marked during the processing
+         * (frame allocation yields) are served with the next pass */
+        list = dirty, dirty = 0, dirty_tail = &dirty;
+        /* process the sockets */
+        while ((sock = list)) {
+            list = sock->dnext, sock->dirty = 0;
+            /* frame could not be sent, try again with the next pass */
+            if (TCPIPTcpSock_ProcessOutgoing(sock) != EOK)
+                TCPIPTcpSock_MarkDirty(sock);
+            /* wait for the timers */
+            TCPIPTcpSock_Schedule(sock);
+        }
         /* relase the socket access */
-        Sem_Release(&lock);
+        Mutex_Release(&lock);
     }
 }
 
 /* initialize tcp socket layer */
 err_t TCPIPTcpSock_Init(void)
 {
+    /* allocate the socket table */
+    sockets_num = sysconf.tcp_sock_num;
+    sockets = Heap_Malloc(sockets_num * sizeof(*sockets));
+    /* sanity check */
+    assert(sockets, "unable to allocate tcp socket table");
+    /* all sockets are free */
+    memset(sockets, 0, sockets_num * sizeof(*sockets));
+
+    /* allocate the lookup tables */
+    tbl_size = TCPIPSockHash_GetSize(sockets_num);
+    conn_tbl = Heap_Malloc(2 * tbl_size * sizeof(*conn_tbl));
+    /* sanity check */
+    assert(conn_tbl, "unable to allocate tcp lookup tables");
+    /* both tables share the allocation, all chains are empty */
+    lstn_tbl = conn_tbl + tbl_size;
+    memset(conn_tbl, 0, 2 * tbl_size * sizeof(*conn_tbl));
+
     /* create the task */
     Yield_Task(TCPIPTcpSock_Output, 0, 1024);
     /* report status */
@@ -396,7 +945,7 @@ err_t TCPIPTcpSock_Reset(void)
     /* socket pointer */
     tcpip_tcp_sock_t *sock;
     /* look for socket that this message may be directed to */
-    for (sock = sockets; sock != sockets + elems(sockets); sock++)
+    for (sock = sockets; sock != sockets + sockets_num; sock++)
         if (sock->state != TCPIP_TCP_SOCK_STATE_FREE &&
             sock->state != TCPIP_TCP_SOCK_STATE_CLOSED)
             sock->state = TCPIP_TCP_SOCK_STATE_CLOSED;
@@ -412,16 +961,29 @@ err_t TCPIPTcpSock_Input(tcpip_frame_t *frame)
     tcpip_tcp_sock_t *sock; err_t ec = EFATAL;
 
     /* lock onto the sockets */
-    Sem_Lock(&lock, 0);
+    Mutex_Lock(&lock, 0);
     /* look for socket that this message may be directed to */
-    for (sock = sockets; sock != sockets + elems(sockets); sock++)
-        if ((ec = TCPIPTcpSock_ProcessIncoming(frame, sock)) == EOK)
-            break;
+    sock = TCPIPTcpSock_Lookup(TCPIPIpFrame_GetSrcAddr(frame->ip),
+        TCPIPTcpFrame_GetSrcPort(frame->tcp),
+        TCPIPTcpFrame_GetDstPort(frame->tcp));
+    /* listening sockets with backlog establish the connections using the
+     * sockets from their pool */
+    if (sock && sock->backlog) {
+        sock = TCPIPTcpFrame_GetFlags(frame->tcp) & TCPIP_TCP_FLAGS_SYN ?
+            TCPIPTcpSock_GetChild(sock) : 0;
+    }
+    /* let the socket process the frame */
+    if (sock && (ec = TCPIPTcpSock_ProcessIncoming(frame, sock)) != EOK &&
+        sock->parent && sock->state == TCPIP_TCP_SOCK_STATE_LISTEN)
+        sock->state = TCPIP_TCP_SOCK_STATE_CLOSED;
+    /* frame may require a response */
+    if (sock)
+        TCPIPTcpSock_MarkDirty(sock);
     // /* nobody did serve the request TODO: this may not be cool thing to do */
     // if (ec != EOK)
     //     TCPIPTcpSock_Reject(frame);
     /* release the sockets */
-    Sem_Release(&lock);
+    Mutex_Release(&lock);
 
     /* wasn't able to process the frame, but do not answer. client will resend
      * the frame at some later time */
@@ -435,16 +997,18 @@ tcpip_tcp_sock_t * TCPIPTcpSock_Create(size_t rx_size, size_t tx_size)
     tcpip_tcp_sock_t *sock;
 
     /* look for the free socket */
-    for (sock = sockets; sock != sockets + elems(sockets); sock++)
+    for (sock = sockets; sock != sockets + sockets_num; sock++)
         if (sock->state == TCPIP_TCP_SOCK_STATE_FREE)
             break;
 
     /* none found? */
-    if (sock == sockets + elems(sockets))
+    if (sock == sockets + sockets_num)
         return 0;
 
     /* mark socket as closed so that others cannot allocate */
     sock->state = TCPIP_TCP_SOCK_STATE_CLOSED;
+    /* small writes are coalesced by default */
+    sock->tx_nodelay = 0;
     /* create both queues for passing data to/from socket */
     sock->rxq = Queue_Create(1, rx_size);
     sock->txq = Queue_Create(1, tx_size);
@@ -466,19 +1030,14 @@ err_t TCPIPTcpSock_Listen(tcpip_tcp_sock_t *sock, tcpip_tcp_port_t port,
     if (!port)
         return EARGVAL;
 
-    /* reset control flags */
-    sock->tx_flags = sock->rx_flags = 0;
-    /* setup the port number and advance to listen state */
-    sock->loc_port = port;
-    sock->state = TCPIP_TCP_SOCK_STATE_LISTEN;
-    /* close both sides of the link */
-    sock->loc_link = TCPIP_TCP_LINK_STATE_CLOSED;
-    sock->rem_link = TCPIP_TCP_LINK_STATE_CLOSED;
-
-    /* clear the queues */
-    Queue_Drop(sock->rxq, Queue_GetUsed(sock->rxq));
-    Queue_Drop(sock->txq, Queue_GetUsed(sock->txq));
-
+    /* socket takes the connection by itself */
+    sock->backlog = 0;
+    /* reset the state */
+    TCPIPTcpSock_PrepareListen(sock, port);
+    /* make the socket visible to the incoming frames */
+    Mutex_Lock(&lock, 0);
+    TCPIPTcpSock_Hash(sock, &lstn_tbl[TCPIPSockHash_Port(port, tbl_size)]);
+    Mutex_Release(&lock);
 
     /* wait for someone to establish connection */
     for (time_t ts = time(0); ; Yield()) {
@@ -502,6 +1061,88 @@ err_t TCPIPTcpSock_Listen(tcpip_tcp_sock_t *sock, tcpip_tcp_port_t port,
     return EOK;
 }
 
+/* start listening with the queue of connections */
+err_t TCPIPTcpSock_ListenBacklog(tcpip_tcp_sock_t *sock, tcpip_tcp_port_t port,
+    size_t backlog)
+{
+    /* error code */
+    err_t ec = EOK;
+    /* number of sockets in the pool */
+    size_t children = 0;
+
+    /* invalid socket provided */
+    if (!(sock->state == TCPIP_TCP_SOCK_STATE_CLOSED) &&
+        !(sock->state == TCPIP_TCP_SOCK_STATE_LISTEN))
+        return EARGVAL;
+    /* port number and backlog must be non zero */
+    if (!port || !backlog)
+        return EARGVAL;
+
+    /* pool may exist already if we are called again */
+    for (tcpip_tcp_sock_t *s = sockets; s != sockets + sockets_num; s++)
+        if (s->parent == sock)
+            children++;
+    /* create the missing sockets */
+    for (; children < backlog; children++) {
+        /* connections use the same queue sizes as the listening socket */
+        tcpip_tcp_sock_t *child = TCPIPTcpSock_Create(sock->rxq->count,
+            sock->txq->count);
+        /* no more free sockets */
+        if (!child) {
+            ec = EBUSY; break;
+        }
+        /* attach to the listening socket */
+        child->parent = sock;
+    }
+
+    /* store the number of connections that we can handle */
+    sock->backlog = children;
+    /* reset the state */
+    TCPIPTcpSock_PrepareListen(sock, port);
+    /* make the socket visible to the incoming frames */
+    Mutex_Lock(&lock, 0);
+    TCPIPTcpSock_Hash(sock, &lstn_tbl[TCPIPSockHash_Port(port, tbl_size)]);
+    Mutex_Release(&lock);
+
+    /* report status */
+    return ec;
+}
+
+/* take over the connection established on the listening socket */
+err_t TCPIPTcpSock_Accept(tcpip_tcp_sock_t *sock, tcpip_tcp_sock_t **conn,
+    dtime_t timeout)
+{
+    /* socket must be listening with backlog */
+    if (!sock->backlog)
+        return EARGVAL;
+
+    /* wait for the connection */
+    for (time_t ts = time(0); ; Yield()) {
+        /* listening socket was closed in the meantime */
+        if (sock->state != TCPIP_TCP_SOCK_STATE_LISTEN)
+            return ENOCONNECT;
+
+        /* oldest connection that was not accepted yet */
+        tcpip_tcp_sock_t *oldest = 0;
+        /* data may have been exchanged already, or even the connection may
+         * be closing but the application still needs to see that */
+        for (tcpip_tcp_sock_t *s = sockets; s != sockets + sockets_num; s++)
+            if (s->parent == sock && !s->accepted &&
+                s->state >= TCPIP_TCP_SOCK_STATE_ESTABLISHED &&
+                (!oldest || (int32_t)(s->arrival - oldest->arrival) < 0))
+                oldest = s;
+        /* got one */
+        if (oldest) {
+            oldest->accepted = 1, *conn = oldest;
+            return EOK;
+        }
+
+        /* timeout support */
+        if (timeout && dtime_now(ts) > timeout)
+            return ETIMEOUT;
+    }
+}
+
 /* establish the connection to the remote party */
 err_t TCPIPTcpSock_Connect(tcpip_tcp_sock_t *sock, tcpip_ip_addr_t ip,
     tcpip_tcp_port_t port, dtime_t timeout)
@@ -531,9 +1172,25 @@ err_t TCPIPTcpSock_Connect(tcpip_tcp_sock_t *sock, tcpip_ip_addr_t ip,
     sock->loc_port = Seed_GetRand() % 34567 + 10000;
     /* initiate sequence numbers */
     sock->tx_seq_start = sock->tx_seq_init = time(0);
+    sock->tx_seq_next = sock->tx_seq_end = sock->tx_seq_start;
+    /* reset retransmission stuff */
+    sock->tx_retr_cnt = 0;
+    TCPIPTcpSock_ResetRtt(sock);
+    /* options that we offer in syn */
+    sock->opts = TCPIP_TCP_OPTS_WSCALE | TCPIP_TCP_OPTS_TS |
+        TCPIP_TCP_OPTS_SACK_PERM;
+    sock->rx_wscale = TCPIPTcpSock_GetWScale(sock), sock->tx_wscale = 0;
+    sock->tx_mss = 536;
 
     /* move the socket to connect state to cause SYN frame to be sent */
     sock->state = TCPIP_TCP_SOCK_STATE_CONNECT;
+    /* make the socket visible to the incoming frames */
+    Mutex_Lock(&lock, 0);
+    TCPIPTcpSock_Hash(sock, &conn_tbl[TCPIPSockHash_Conn(ip, port,
+        sock->loc_port, tbl_size)]);
+    /* syn needs to be sent */
+    TCPIPTcpSock_MarkDirty(sock);
+    Mutex_Release(&lock);
     /* close both sides of the link */
     sock->loc_link = TCPIP_TCP_LINK_STATE_CLOSED;
     sock->rem_link = TCPIP_TCP_LINK_STATE_CLOSED;
@@ -578,6 +1235,9 @@ err_t TCPIPTcpSock_Recv(tcpip_tcp_sock_t *sock, void *ptr, size_t size,
         Yield();
     }
 
+    /* space was freed, window update may be due */
+    if (b_read)
+        TCPIPTcpSock_MarkDirty(sock);
     /* report the number of bytes read */
     return b_read;
 }
@@ -602,6 +1262,9 @@ err_t TCPIPTcpSock_Send(tcpip_tcp_sock_t *sock, const void *ptr, size_t size,
         /* write next chunk of data into buffer */
         b_stored = Queue_Put(sock->txq,
             (const uint8_t *)ptr + b_written, size - b_written);
+        /* new data to be sent */
+        if (b_stored)
+            TCPIPTcpSock_MarkDirty(sock);
         /* not all data was sent? */
         if ((b_written += b_stored) < size)
             Yield();
@@ -612,11 +1275,38 @@ err_t TCPIPTcpSock_Send(tcpip_tcp_sock_t *sock, const void *ptr, size_t size,
     return b_written;
 }
 
+/* enable/disable the coalescing of small writes */
+err_t TCPIPTcpSock_SetNoDelay(tcpip_tcp_sock_t *sock, int enable)
+{
+    /* store the setting, it takes effect with the next segment */
+    sock->tx_nodelay = !!enable;
+    /* data that was held back may go now */
+    TCPIPTcpSock_MarkDirty(sock);
+    /* report status */
+    return EOK;
+}
+
+/* get the round trip time estimate */
+dtime_t TCPIPTcpSock_GetRtt(tcpip_tcp_sock_t *sock)
+{
+    /* smoothed value is kept scaled */
+    return sock->tx_srtt >> 3;
+}
+
+/* get the retransmission timeout */
+dtime_t TCPIPTcpSock_GetRto(tcpip_tcp_sock_t *sock)
+{
+    /* current value, back-off included */
+    return sock->tx_rto;
+}
+
 /* close the socket */
 err_t TCPIPTcpSock_Close(tcpip_tcp_sock_t *sock, dtime_t timeout)
 {
     /* current timestamp */
     time_t ts = time(0);
+    /* error code */
+    err_t ec = EOK;
 
     /* socket in weird state */
     if ((sock->state == TCPIP_TCP_SOCK_STATE_FREE) ||
@@ -628,7 +1318,7 @@ err_t TCPIPTcpSock_Close(tcpip_tcp_sock_t *sock, dtime_t timeout)
            Queue_GetUsed(sock->txq) != 0) {
         /* timeout support */
         if (timeout && dtime(time(0), ts) > timeout) {
-            sock->state = TCPIP_TCP_SOCK_STATE_CLOSED; return ETIMEOUT;
+            ec = ETIMEOUT; goto end;
         }
         /* still waiting */
         Yield();
@@ -639,17 +1329,23 @@ err_t TCPIPTcpSock_Close(tcpip_tcp_sock_t *sock, dtime_t timeout)
         sock->loc_link = TCPIP_TCP_LINK_STATE_CLOSING;
         sock->state = TCPIP_TCP_SOCK_STATE_CLOSING;
         sock->syn_fin_ts = time(0);
+        /* fin needs to be sent */
+        TCPIPTcpSock_MarkDirty(sock);
     }
     /* wait for the closure */
     while (sock->state != TCPIP_TCP_SOCK_STATE_CLOSED) {
         /* timeout support */
         if (timeout && dtime(time(0), ts) > timeout) {
-            sock->state = TCPIP_TCP_SOCK_STATE_CLOSED; return ETIMEOUT;
+            ec = ETIMEOUT; goto end;
         }
         /* still waiting */
         Yield();
     }
 
-    /* return success */
-    return EOK;
+    /* connection is over, accepted sockets go back to the listening socket's
+     * pool */
+    end: sock->state = TCPIP_TCP_SOCK_STATE_CLOSED;
+    sock->accepted = 0;
+    /* return status */
+    return ec;
 }
\ No newline at end of file
@@ -13,6 +13,7 @@
 #include "net/tcpip/icmp.h"
 #include "net/tcpip/ip.h"
 #include "net/tcpip/udp.h"
+#include "net/tcpip/udp_sock.h"
 #include "net/tcpip/tcp.h"
 #include "net/tcpip/tcp_sock.h"
 #include "net/tcpip/rxtx.h"
@@ -34,6 +35,8 @@ err_t TCPIP_Init(void)
     TCPIPIcmp_Init();
     /* initialize udp layer */
     TCPIPUdp_Init();
+    /* initialize udp socket layer */
+    TCPIPUdpSock_Init();
     /* initialize tcp layer */
     TCPIPTcp_Init();
     /* initialize tcp socket layer */
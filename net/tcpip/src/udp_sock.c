@@ -16,11 +16,13 @@
 #include "err.h"
 #include "net/tcpip/ip.h"
 #include "net/tcpip/ip_addr.h"
+#include "net/tcpip/sock_hash.h"
 #include "net/tcpip/udp.h"
 #include "net/tcpip/udp_frame.h"
 #include "net/tcpip/udp_sock.h"
 #include "sys/heap.h"
-#include "sys/queue.h"
+#include "sys/msgq.h"
+#include "sys/sysconf.h"
 #include "sys/time.h"
 #include "sys/yield.h"
 #include "util/elems.h"
@@ -29,18 +31,41 @@
 #include "util/string.h"
 
 
-/* sockets */
-static tcpip_udp_sock_t sockets[TCPIP_UDP_SOCK_NUM];
-/* type for the information contained within the socket's rxq that preceeds any 
+/* sockets (table is sized at boot, see sysconf.h) */
+static tcpip_udp_sock_t *sockets; static size_t sockets_num;
+/* lookup table (sockets are hashed by the local port) */
+static tcpip_udp_sock_t **tbl; static size_t tbl_size;
+
+/* initialize udp socket layer */
+err_t TCPIPUdpSock_Init(void)
+{
+    /* allocate the socket table */
+    sockets_num = sysconf.udp_sock_num;
+    sockets = Heap_Malloc(sockets_num * sizeof(*sockets));
+    /* sanity check */
+    assert(sockets, "unable to allocate udp socket table");
+    /* all sockets are free */
+    memset(sockets, 0, sockets_num * sizeof(*sockets));
+
+    /* allocate the lookup table */
+    tbl_size = TCPIPSockHash_GetSize(sockets_num);
+    tbl = Heap_Malloc(tbl_size * sizeof(*tbl));
+    /* sanity check */
+    assert(tbl, "unable to allocate udp lookup table");
+    /* all chains are empty */
+    memset(tbl, 0, tbl_size * sizeof(*tbl));
+
+    /* report status */
+    return EOK;
+}
+/* type for the information contained within the socket's rxq that preceeds any
  * frame data */
 typedef struct rxq_hdr {
-    /* size of the frame contents */
-    size_t size;
     /* source ip adddress */
     tcpip_ip_addr_t ip;
     /* source port */
     tcpip_udp_port_t port;
-} PACKED rxq_hdr_t;
+} rxq_hdr_t;
 
 /* push the data into socket */
 static err_t TCPIPUdpSock_ProcessIncoming(tcpip_frame_t *frame, 
@@ -50,27 +75,16 @@ static err_t TCPIPUdpSock_ProcessIncoming(tcpip_frame_t *frame,
     tcpip_udp_frame_t *udp = frame->udp;
     /* extract port information */
     tcpip_udp_port_t dst_port = TCPIPUdpFrame_GetDstPort(udp);
-    tcpip_udp_port_t src_port = TCPIPUdpFrame_GetSrcPort(udp);
-    /* source ip address */
-    tcpip_ip_addr_t ip = TCPIPIpFrame_GetSrcAddr(frame->ip);
-
     /* not the destination socket */
     if (!sock->loc_port || sock->loc_port != dst_port)
         return EUNREACHABLE;
-    
-    /* determine how many bytes are we about to put in rxq */
-    size_t b_to_put = sizeof(size_t) + sizeof(ip) + sizeof(src_port) +
-        frame->size;
-    /* unable to store incoming frame */
-    if (Queue_GetFree(sock->rxq) < b_to_put)
-        return EOK;
-    
-    /* store the meta-data */
-    Queue_Put(sock->rxq, &frame->size, sizeof(frame->size));
-    Queue_Put(sock->rxq, &ip, sizeof(ip));
-    Queue_Put(sock->rxq, &src_port, sizeof(src_port));
-    /* store the frame contents */
-    Queue_Put(sock->rxq, frame->ptr, frame->size);
+
+    /* source ip address and port go into the record header */
+    rxq_hdr_t hdr = { .ip = TCPIPIpFrame_GetSrcAddr(frame->ip), 
+        .port = TCPIPUdpFrame_GetSrcPort(udp) };
+    /* store the datagram as a whole, if there is no space for it then it's
+     * simply dropped */
+    MsgQ_Put(sock->rxq, &hdr, sizeof(hdr), frame->ptr, frame->size);
 
     /* report success */
     return EOK;
@@ -81,9 +95,12 @@ err_t TCPIPUdpSock_Input(tcpip_frame_t *frame)
 {
     /* error code */
     err_t ec = EFATAL;
+    /* destination port */
+    tcpip_udp_port_t port = TCPIPUdpFrame_GetDstPort(frame->udp);
 
-    /* process the frame with respect to all sockets */
-    for (tcpip_udp_sock_t *s = sockets; s != sockets + elems(sockets); s++)
+    /* process the frame with respect to sockets bound to the port */
+    for (tcpip_udp_sock_t *s = tbl[TCPIPSockHash_Port(port, tbl_size)]; s;
+        s = s->hnext)
         if ((ec = TCPIPUdpSock_ProcessIncoming(frame, s)) == EOK)
             break;
     /* this will be set to ok if any of the sockets accepts incoming frame */
@@ -98,19 +115,22 @@ tcpip_udp_sock_t * TCPIPUdpSock_CreateSocket(tcpip_udp_port_t port,
     tcpip_udp_sock_t *sock;
 
     /* look for the free socket */
-    for (sock = sockets; sock != sockets + elems(sockets); sock++)
+    for (sock = sockets; sock != sockets + sockets_num; sock++)
         if (sock->loc_port == 0)
             break;
     
     /* none found? */
-    if (sock == sockets + elems(sockets))
+    if (sock == sockets + sockets_num)
         return 0;
     
     /* allocate memory for the incoming frames */
-    sock->rxq = Queue_Create(1, rx_size);
+    sock->rxq = MsgQ_Create(rx_size);
     sock->loc_port = port;
     /* sanity check */
     assert(sock->rxq, "unable to allocte memory for udp socket\n");
+    /* link the socket into the lookup table */
+    tcpip_udp_sock_t **bucket = &tbl[TCPIPSockHash_Port(port, tbl_size)];
+    sock->hnext = *bucket, *bucket = sock;
     /* return socket pointer */
     return sock;
 }
@@ -118,8 +138,14 @@ tcpip_udp_sock_t * TCPIPUdpSock_CreateSocket(tcpip_udp_port_t port,
 /* destroy previously created socket */
 void TCPIPUdpSock_DestroySocket(tcpip_udp_sock_t *sock)
 {
-    /* clear the port number */
-    Queue_Destroy(sock->rxq);
+    /* unlink the socket from the lookup table */
+    for (tcpip_udp_sock_t **pp = &tbl[TCPIPSockHash_Port(sock->loc_port,
+        tbl_size)]; *pp; pp = &(*pp)->hnext)
+        if (*pp == sock) {
+            *pp = sock->hnext; break;
+        }
+    /* release the datagram queue */
+    MsgQ_Destroy(sock->rxq);
     /* socket record is free when it's local port is set to 0 */
     sock->loc_port = 0;
 }
@@ -128,31 +154,19 @@ void TCPIPUdpSock_DestroySocket(tcpip_udp_sock_t *sock)
 err_t TCPIPUdpSock_RecvFrom(tcpip_udp_sock_t *sock, tcpip_ip_addr_t *addr, 
     tcpip_udp_port_t *port, void *ptr, size_t size, dtime_t timeout)
 {
-    /* previous frame was consumed. we need to wait for another one to arrive 
-     * and get stored within our buffers */
-    if (sock->rx_offs == sock->rx_size) {
-        /* wait for the 1st data that constitutes the header. if it's present 
-         * then we can be sure that the rest of the data is also present since
-         * we use coop mutli-tasking mode */
-        if (Queue_GetWait(sock->rxq, &sock->rx_size, sizeof(sock->rx_size), 
-            timeout) == 0)
-            return ETIMEOUT;
-        /* continue with the rest of the meta-data */
-        Queue_Get(sock->rxq, &sock->rx_ip, sizeof(sock->rx_ip));
-        Queue_Get(sock->rxq, &sock->rx_port, sizeof(sock->rx_port));
-        /* reset the offset counter */
-        sock->rx_offs = 0;
-    }
+    /* datagram header */
+    rxq_hdr_t hdr;
+    /* wait for the datagram and fetch it as a whole */
+    err_t ec = MsgQ_GetWait(sock->rxq, &hdr, sizeof(hdr), ptr, size, timeout);
+    /* nothing was received */
+    if (ec < EOK)
+        return ec;
 
     /* setup the address and port information */
-    *addr = sock->rx_ip;
-    *port = sock->rx_port;
-
-    /* read the data, but no more that what is left within current frame */
-    size = Queue_Get(sock->rxq, ptr, min(size, sock->rx_size));
-    sock->rx_offs += size;
+    *addr = hdr.ip;
+    *port = hdr.port;
     /* return the number of bytes received */
-    return size;
+    return ec;
 }
 
 /* send to remote party */
@@ -15,6 +15,7 @@
 
 #include "err.h"
 #include "net/tcpip/tcpip.h"
+#include "net/tcpip/tcp_opts.h"
 
 /**
  * @brief Initialize tcp layer
@@ -51,7 +52,9 @@ err_t TCPIPTcp_Alloc(tcpip_frame_t *frame);
 err_t TCPIPTcp_Drop(tcpip_frame_t *frame);
 
 /**
- * @brief Sends pre-allocated tcp frame
+ * @brief Sends pre-allocated tcp frame. When options are to be sent then the
+ * payload must be placed after the space for them (see
+ * TCPIPTcpOpts_GetSize())
  * 
  * @param frame allocated frame pointer
  * @param da destination ip address
@@ -61,11 +64,13 @@ err_t TCPIPTcp_Drop(tcpip_frame_t *frame);
  * @param ack acknoledgement number
  * @param win window size
  * @param flags tcp flags
+ * @param opts options to be sent (or null)
  * 
  * @return err_t send status
  */
 err_t TCPIPTcp_Send(tcpip_frame_t *frame, tcpip_ip_addr_t da, 
     tcpip_tcp_port_t src_port, tcpip_tcp_port_t dst_port,
-    uint32_t seq, uint32_t ack, uint16_t win, tcpip_tcp_flags_t flags);
+    uint32_t seq, uint32_t ack, uint16_t win, tcpip_tcp_flags_t flags,
+    const tcpip_tcp_opts_t *opts);
 
 #endif /* NET_TCPIP_TCP_H */
@@ -0,0 +1,104 @@
+/**
+ * @file tcp_opts.h
+ *
+ * @author Tomasz Watorowski (tomasz.watorowski@gmail.com)
+ * @date 2025-05-02
+ *
+ * @brief TCP/IP Stack: Transmission Control Protocol options (maximal segment
+ * size, window scale, timestamps, selective acknowledgements)
+ */
+
+#ifndef NET_TCPIP_TCP_OPTS_H
+#define NET_TCPIP_TCP_OPTS_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "err.h"
+
+/** option kinds */
+typedef enum tcpip_tcp_opts_kind {
+    /** end of the option list */
+    TCPIP_TCP_OPTS_KIND_END         = 0,
+    /** no operation (padding) */
+    TCPIP_TCP_OPTS_KIND_NOP         = 1,
+    /** maximal segment size */
+    TCPIP_TCP_OPTS_KIND_MSS         = 2,
+    /** window scale */
+    TCPIP_TCP_OPTS_KIND_WSCALE      = 3,
+    /** selective acknowledgements permitted */
+    TCPIP_TCP_OPTS_KIND_SACK_PERM   = 4,
+    /** selective acknowledgement blocks */
+    TCPIP_TCP_OPTS_KIND_SACK        = 5,
+    /** timestamps */
+    TCPIP_TCP_OPTS_KIND_TS          = 8,
+} tcpip_tcp_opts_kind_t;
+
+/** option presence flags */
+typedef enum tcpip_tcp_opts_flags {
+    /** maximal segment size is present */
+    TCPIP_TCP_OPTS_MSS              = 0x01,
+    /** window scale is present */
+    TCPIP_TCP_OPTS_WSCALE           = 0x02,
+    /** timestamps are present */
+    TCPIP_TCP_OPTS_TS               = 0x04,
+    /** selective acknowledgements are permitted */
+    TCPIP_TCP_OPTS_SACK_PERM        = 0x08,
+    /** selective acknowledgement blocks are present */
+    TCPIP_TCP_OPTS_SACK             = 0x10,
+} tcpip_tcp_opts_flags_t;
+
+/** maximal window scale shift allowed (rfc7323) */
+#define TCPIP_TCP_OPTS_WSCALE_MAX   14
+/** maximal number of sack blocks (that fit together with timestamps) */
+#define TCPIP_TCP_OPTS_SACK_MAX     3
+
+/** options carried by the segment */
+typedef struct tcpip_tcp_opts {
+    /** which of the options are present */
+    tcpip_tcp_opts_flags_t flags;
+    /** maximal segment size */
+    uint16_t mss;
+    /** window scale shift */
+    uint8_t wscale;
+    /** timestamp value and the timestamp echo reply */
+    uint32_t ts_val, ts_ecr;
+    /** number of sack blocks */
+    uint8_t sack_num;
+    /** sack blocks: sequence number ranges received out of order, first
+     * block holds the most recently received segment */
+    struct { uint32_t start, end; } sack[TCPIP_TCP_OPTS_SACK_MAX];
+} tcpip_tcp_opts_t;
+
+/**
+ * @brief parse the options area of the tcp header. Unknown options are
+ * skipped, options of invalid length are ignored.
+ *
+ * @param ptr options area pointer (right after the fixed header)
+ * @param size size of the options area
+ * @param opts placeholder for the parsed options
+ *
+ * @return err_t EOK or EMALFORMED if the option list is broken
+ */
+err_t TCPIPTcpOpts_Parse(const void *ptr, size_t size, tcpip_tcp_opts_t *opts);
+
+/**
+ * @brief get the size of the rendered options (multiple of 4)
+ *
+ * @param opts options to be rendered
+ *
+ * @return size_t size in bytes
+ */
+size_t TCPIPTcpOpts_GetSize(const tcpip_tcp_opts_t *opts);
+
+/**
+ * @brief render the options (padded with nops to the multiple of 4)
+ *
+ * @param ptr options area pointer
+ * @param opts options to be rendered
+ *
+ * @return size_t number of bytes written
+ */
+size_t TCPIPTcpOpts_Render(void *ptr, const tcpip_tcp_opts_t *opts);
+
+#endif /* NET_TCPIP_TCP_OPTS_H */
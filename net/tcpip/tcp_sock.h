@@ -14,8 +14,10 @@
 #include <stdint.h>
 #include <stddef.h>
 
+#include "config.h"
 #include "err.h"
 #include "net/tcpip/tcpip.h"
+#include "net/tcpip/tcp_opts.h"
 #include "sys/queue.h"
 #include "sys/time.h"
 
@@ -59,22 +61,85 @@ typedef struct tcpip_tcp_sock {
     tcpip_tcp_flags_t rx_flags;
     /** last communicated window size */
     uint32_t rx_win;
+    /** sequence ranges that were received out of order (most recently
+     * updated one goes first), data is kept in the rxq free space at the
+     * offset that corresponds to the distance from rx_seq_recvd */
+    struct { uint32_t start, end; } rx_ooo[TCPIP_TCP_OOO_NUM];
+    /** number of out of order ranges */
+    uint8_t rx_ooo_num;
+    /** number of segments received since the last ack was sent (ack is sent
+     * at once when it reaches TCPIP_TCP_ACK_SEGS) and the reception time of
+     * the first one */
+    uint8_t rx_ack_cnt; time_t rx_ack_ts;
 
     /** initial value of the transmit sequence */
     uint32_t tx_seq_init;
-    /** next sequence number to send */
-    uint32_t tx_seq_start, tx_seq_end;
-    /** transmission window */
+    /** oldest unacknowledged sequence number (corresponds to the beginning
+     * of the txq), next sequence number to be sent, highest sequence number
+     * sent so far */
+    uint32_t tx_seq_start, tx_seq_next, tx_seq_end;
+    /** transmission window advertised by the remote site */
     uint32_t tx_win;
     /** transmitted flags */
     tcpip_tcp_flags_t tx_flags;
-    /* retransmission timer */
+    /* retransmission timer (started when the oldest unacknowledged segment
+     * was sent) */
     time_t tx_retr_ts;
-    /* retransmission counter */
+    /* number of transmissions of the oldest unacknowledged segment */
     uint32_t tx_retr_cnt;
+    /** retransmission timeout (with the back-off applied) */
+    uint32_t tx_rto;
+    /** smoothed round trip time (scaled by 8) and it's variation (scaled by
+     * 4), both are zero until the first measurement is made */
+    uint32_t tx_srtt, tx_rttvar;
+    /** segment being timed (when timestamps were not negotiated) along with
+     * it's transmission time */
+    uint32_t tx_rtt_seq; time_t tx_rtt_ts;
+    /** round trip time measurement is in progress */
+    uint8_t tx_rtt_on;
+    /** small segments are sent even if there is unacknowledged data in
+     * flight (nagle's algorithm disabled) */
+    uint8_t tx_nodelay;
 
     /* strange state protector */
     time_t syn_fin_ts;
+
+    /** lookup table linkage: next socket in the chain and the bucket that
+     * the socket is linked into (listeners are looked up by the local port,
+     * others by the connection identifier) */
+    struct tcpip_tcp_sock *hnext, **hbucket;
+
+    /** output processing is only done for the sockets that have work
+     * pending: next socket on the list of sockets that need processing (and
+     * the flag telling that the socket is on that list), next socket in the
+     * timer queue (and the flag telling that the socket is queued) */
+    struct tcpip_tcp_sock *dnext, *tnext; uint8_t dirty, timed;
+    /** time at which the socket needs attention even if nothing happens in
+     * the meantime (retransmission, delayed ack, closing guard) */
+    time_t deadline;
+
+    /** listening socket that owns this socket (connections established on
+     * behalf of the listening socket with backlog) */
+    struct tcpip_tcp_sock *parent;
+    /** number of connections that the listening socket handles at once
+     * (0 - socket accepts a single connection by itself) */
+    uint16_t backlog;
+    /** connection was handed over to the application */
+    uint8_t accepted;
+    /** order in which the connection request arrived (connections are
+     * handed over to the application oldest first) */
+    uint32_t arrival;
+
+    /** options offered (before the connection is established) or
+     * negotiated for the connection (window scale, timestamps, sack) */
+    tcpip_tcp_opts_flags_t opts;
+    /** maximal segment size accepted by the remote site */
+    uint16_t tx_mss;
+    /** window scale shifts: applied to the windows received from the
+     * remote site and to the ones we advertise */
+    uint8_t tx_wscale, rx_wscale;
+    /** most recent timestamp received from the remote site (echoed back) */
+    uint32_t ts_recent;
 } tcpip_tcp_sock_t;
 
 
@@ -124,6 +189,39 @@ tcpip_tcp_sock_t * TCPIPTcpSock_Create(size_t rx_size, size_t tx_size);
 err_t TCPIPTcpSock_Listen(tcpip_tcp_sock_t *sock, tcpip_tcp_port_t port,
     dtime_t timeout);
 
+/**
+ * @brief Start listening on selected port with the queue of connections. Does
+ * not wait: connections are established on behalf of the listening socket
+ * using the pool of sockets that is created here (with the same queue sizes
+ * as the listening socket) and are handed over to the application with
+ * TCPIPTcpSock_Accept(). Closing the accepted socket returns it to the pool.
+ * Connection requests that arrive when the pool is used up are dropped (and
+ * retried by the remote site).
+ *
+ * @param sock socket descriptor
+ * @param port port number to listen onto
+ * @param backlog number of connections handled at once (ones that wait for
+ * being accepted and the ones that were accepted but not closed yet)
+ *
+ * @return err_t error code, EBUSY if the pool could not be created in full
+ */
+err_t TCPIPTcpSock_ListenBacklog(tcpip_tcp_sock_t *sock, tcpip_tcp_port_t port,
+    size_t backlog);
+
+/**
+ * @brief Wait for the connection to be established on the listening socket
+ * (see TCPIPTcpSock_ListenBacklog()) and take it over. Connections are handed
+ * over in the order of arrival.
+ *
+ * @param sock listening socket descriptor
+ * @param conn placeholder for the connected socket descriptor
+ * @param timeout max time that we wait for the connection (0 - forever)
+ *
+ * @return err_t error code
+ */
+err_t TCPIPTcpSock_Accept(tcpip_tcp_sock_t *sock, tcpip_tcp_sock_t **conn,
+    dtime_t timeout);
+
 /**
  * @brief Initiate the connection establishment procedure to selected remote
  * ip/port
@@ -166,6 +264,37 @@ err_t TCPIPTcpSock_Recv(tcpip_tcp_sock_t *sock, void *ptr, size_t size,
 err_t TCPIPTcpSock_Send(tcpip_tcp_sock_t *sock, const void *ptr, size_t size,
     dtime_t timeout);
 
+/**
+ * @brief Enable or disable sending of small segments while there is data that
+ * was not acknowledged yet. By default small writes are coalesced (nagle's
+ * algorithm) which adds latency for the request/response traffic that does
+ * not wait for the response before sending more.
+ *
+ * @param sock socket descriptor
+ * @param enable 1 - send at once, 0 - coalesce small writes
+ *
+ * @return err_t error code
+ */
+err_t TCPIPTcpSock_SetNoDelay(tcpip_tcp_sock_t *sock, int enable);
+
+/**
+ * @brief Get the smoothed round trip time estimate for the connection
+ *
+ * @param sock socket descriptor
+ *
+ * @return dtime_t round trip time in ms (0 if not measured yet)
+ */
+dtime_t TCPIPTcpSock_GetRtt(tcpip_tcp_sock_t *sock);
+
+/**
+ * @brief Get the current retransmission timeout of the connection
+ *
+ * @param sock socket descriptor
+ *
+ * @return dtime_t retransmission timeout in ms (with back-off applied)
+ */
+dtime_t TCPIPTcpSock_GetRto(tcpip_tcp_sock_t *sock);
+
 /**
  * @brief Close the connection
  *
@@ -15,24 +15,22 @@
 
 #include "err.h"
 #include "net/tcpip/tcpip.h"
-#include "sys/queue.h"
+#include "sys/msgq.h"
 #include "sys/time.h"
 
 /** udp socket */
 typedef struct tcpip_udp_sock_t {
     /** local port/ remote port */
     tcpip_udp_port_t loc_port;
-    /** received data queue */
-    queue_t *rxq;
-    /** current frame data */
-    size_t rx_offs, rx_size;
-    /** ip address that we are receiiving from */
-    tcpip_ip_addr_t rx_ip;
-    /** port that we are receiving from */
-    tcpip_udp_port_t rx_port;
+    /** received datagrams queue */
+    msgq_t *rxq;
+    /** next socket within the lookup table chain */
+    struct tcpip_udp_sock_t *hnext;
 } tcpip_udp_sock_t;
 
 
+/* initialize udp socket layer */
+err_t TCPIPUdpSock_Init(void);
 /* input routine to the socketization layer */
 err_t TCPIPUdpSock_Input(tcpip_frame_t *frame);
 /* create udp socket */
@@ -40,7 +38,8 @@ tcpip_udp_sock_t * TCPIPUdpSock_CreateSocket(tcpip_udp_port_t port,
     size_t rx_size);
 /* destroy previously created socket */
 void TCPIPUdpSock_DestroySocket(tcpip_udp_sock_t *s);
-/* receive udp data from socket */
+/* receive udp datagram from socket, datagrams larger than 'size' are
+ * truncated */
 err_t TCPIPUdpSock_RecvFrom(tcpip_udp_sock_t *sock, tcpip_ip_addr_t *addr, 
     tcpip_udp_port_t *port, void *ptr, size_t size, dtime_t timeout);
 /* send to remote party */
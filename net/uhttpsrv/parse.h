@@ -0,0 +1,155 @@
+/**
+ * @file parse.h
+ * @author Tomasz Watorowski (tomasz.watorowski@gmail.com)
+ * @date 2025-04-22
+ *
+ * @brief Http server: request/field parsers and renderers. Kept apart from the
+ * server logic so that these can be tested and benchmarked on the host.
+ */
+
+#ifndef NET_UHTTPSRV_PARSE_H
+#define NET_UHTTPSRV_PARSE_H
+
+#include <stdarg.h>
+#include <stddef.h>
+
+#include "err.h"
+#include "net/uhttpsrv/uhttpsrv.h"
+
+/* http method specifier */
+typedef struct uhttp_method_spec {
+    /* method encoding enum */
+    enum uhttp_method method;
+    /* string version of the method name */
+    const char *str;
+} uhttp_method_spec_t;
+
+/* http version specifier */
+typedef struct uhttp_version_spec {
+    /* version enum */
+    enum uhttp_version {
+        HTTP_VER_UNKNOWN,
+        HTTP_VER_1V0,
+        HTTP_VER_1V1,
+        HTTP_VER_2V0,
+        HTTP_VER_3V0,
+    } version;
+    /* string representation */
+    const char *str;
+} uhttp_version_spec_t;
+
+/* specification of a field */
+typedef struct uhttp_field_spec {
+    /* field name */
+    uhttp_field_name_t name;
+    /* field value type */
+    enum uhttp_field_type {
+        HTTP_FIELD_TYPE_INT,
+        HTTP_FIELD_TYPE_FLOAT,
+        HTTP_FIELD_TYPE_STR,
+    } type;
+    /* field string name */
+    const char *str;
+} uhttp_field_spec_t;
+
+/* status code specifier */
+typedef struct uhttp_status_code_t {
+    /* status code enum */
+    uhttp_status_code_t code;
+    /* code value */
+    int value;
+    /* string message */
+    const char *msg;
+} uhttp_status_code_spec_t;
+
+/**
+ * @brief returns the method specifier for given enum or string name (only one
+ * of these shall be provided)
+ *
+ * @param method method enum
+ * @param str method name
+ *
+ * @return const uhttp_method_spec_t * specifier or null if not found
+ */
+const uhttp_method_spec_t * UHTTPSrv_GetMethodSpec(
+    enum uhttp_method method, const char *str);
+
+/**
+ * @brief returns the version specifier for given enum or string name (only one
+ * of these shall be provided)
+ *
+ * @param version version enum
+ * @param str version string
+ *
+ * @return const uhttp_version_spec_t * specifier or null if not found
+ */
+const uhttp_version_spec_t * UHTTPSrv_GetVersionSpec(
+    enum uhttp_version version, const char *str);
+
+/**
+ * @brief get field specification either by name or by field name enum (only
+ * one of these shall be provided)
+ *
+ * @param name field name enum
+ * @param str field name string (matched case insensitive)
+ *
+ * @return const uhttp_field_spec_t * specifier or null if not found
+ */
+const uhttp_field_spec_t * UHTTPSrv_GetFieldSpec(
+    enum uhttp_field_name name, const char *str);
+
+/**
+ * @brief get status code specification either by code or by message (only one
+ * of these shall be provided)
+ *
+ * @param code status code enum
+ * @param msg status message
+ *
+ * @return const uhttp_status_code_spec_t * specifier or null if not found
+ */
+const uhttp_status_code_spec_t * UHTTPSrv_GetStatusCodeSpec(
+    enum uhttp_status_code code, const char *msg);
+
+/**
+ * @brief parse the request line: "method url version"
+ *
+ * @param line line string
+ * @param line_len line length
+ * @param method parsed method
+ * @param url buffer for the url
+ * @param url_size size of the url buffer
+ * @param version parsed version
+ *
+ * @return err_t EOK on success
+ */
+err_t UHTTPSrv_ParseRequestLine(const char *line, size_t line_len,
+    enum uhttp_method *method, char *url, size_t url_size,
+    enum uhttp_version *version);
+
+/**
+ * @brief parse the header field line: "field: value". String values are not
+ * copied, these point to the line.
+ *
+ * @param line line string
+ * @param line_len line length
+ * @param field parsed field
+ *
+ * @return err_t EOK on success
+ */
+err_t UHTTPSrv_ParseFieldLine(const char *line, size_t line_len,
+    uhttp_field_t *field);
+
+/**
+ * @brief render the header field line
+ *
+ * @param out output buffer
+ * @param size size of the output buffer
+ * @param name field name
+ * @param args field value (type depends on the field)
+ *
+ * @return err_t length of the rendered line or error code
+ */
+err_t UHTTPSrv_RenderFieldLine(char *out, size_t size,
+    enum uhttp_field_name name, va_list args);
+
+#endif /* NET_UHTTPSRV_PARSE_H */
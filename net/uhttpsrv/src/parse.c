@@ -0,0 +1,304 @@
+/**
+ * @file parse.c
+ * @author Tomasz Watorowski (tomasz.watorowski@gmail.com)
+ * @date 2025-04-22
+ *
+ * @brief Http server: request/field parsers and renderers
+ */
+
+#include <stdarg.h>
+
+#include "assert.h"
+#include "err.h"
+#include "net/uhttpsrv/parse.h"
+#include "net/uhttpsrv/uhttpsrv.h"
+#include "util/elems.h"
+#include "util/stdio.h"
+#include "util/string.h"
+
+/* returns the method specifier for given enum or string name */
+const uhttp_method_spec_t * UHTTPSrv_GetMethodSpec(
+    enum uhttp_method method, const char *str)
+{
+    /* look up table */
+    static const uhttp_method_spec_t *l, lut[] =  {
+        { HTTP_METHOD_GET, "GET" },
+        { HTTP_METHOD_HEAD, "HEAD" },
+        { HTTP_METHOD_POST, "POST" },
+        { HTTP_METHOD_PUT, "PUT" },
+        { HTTP_METHOD_DELETE, "DELETE" },
+        { HTTP_METHOD_CONNECT, "CONNECT" },
+        { HTTP_METHOD_OPTIONS, "OPTIONS" },
+        { HTTP_METHOD_TRACE, "TRACE" },
+        { HTTP_METHOD_PATCH, "PATCH" },
+    };
+
+    /* sanity check */
+    assert(!(method && str), "only one thing can be specified");
+    assert(method || str, "at least one thing must be specified");
+
+    /* go through the table */
+    for (l = lut; l != lut + elems(lut); l++) {
+        /* enum based search */
+        if (method && method == l->method) return l;
+        /* string based search */
+        if (str && strcmp(l->str, str) == 0) return l;
+    }
+
+    /* nothing was found ;-( */
+    return 0;
+}
+
+/* returns the version specifier for given enum or string name */
+const uhttp_version_spec_t * UHTTPSrv_GetVersionSpec(
+    enum uhttp_version version, const char *str)
+{
+    /* look up table for the conversion */
+    static const uhttp_version_spec_t  *l, lut[] =  {
+        { HTTP_VER_1V0, "HTTP/1.0" },
+        { HTTP_VER_1V1, "HTTP/1.1" },
+        { HTTP_VER_2V0, "HTTP/2" },
+        { HTTP_VER_3V0, "HTTP/3" },
+    };
+
+    /* sanity check */
+    assert(!(version && str), "only one thing can be specified");
+    assert(version || str, "at least one thing must be specified");
+
+    /* go through the table */
+    for (l = lut; l != lut + elems(lut); l++) {
+        /* enum based search */
+        if (version && version == l->version) return l;
+        /* string based search */
+        if (str && strcmp(l->str, str) == 0) return l;
+    }
+
+    /* nothing was found ;-( */
+    return 0;
+}
+
+/* get field specification either by name or by field name enum */
+const uhttp_field_spec_t * UHTTPSrv_GetFieldSpec(
+    enum uhttp_field_name name, const char *str)
+{
+    /* list of supported field types and their parsers */
+    static const uhttp_field_spec_t *l, lut[] = {
+        { HTTP_FIELD_NAME_HOST, HTTP_FIELD_TYPE_STR, "host" },
+        { HTTP_FIELD_NAME_CONTENT_LENGTH, HTTP_FIELD_TYPE_INT, "content-length" },
+        { HTTP_FIELD_NAME_SERVER, HTTP_FIELD_TYPE_STR, "server" },
+        { HTTP_FIELD_NAME_ACCESS_CONTROL_ALLOW_ORIGIN, HTTP_FIELD_TYPE_STR,
+            "access-control-allow-origin" },
+        { HTTP_FIELD_NAME_CONTENT_ENCODING, HTTP_FIELD_TYPE_STR,
+            "content-encoding" },
+        { HTTP_FIELD_NAME_ACCEPT_ENCODING, HTTP_FIELD_TYPE_STR,
+            "accept-encoding" },
+        { HTTP_FIELD_NAME_CONNECTION, HTTP_FIELD_TYPE_STR, "connection" },
+        { HTTP_FIELD_NAME_CONTENT_TYPE, HTTP_FIELD_TYPE_STR, "content-type" },
+        { HTTP_FIELD_NAME_ALLOW, HTTP_FIELD_TYPE_STR, "allow" },
+        { HTTP_FIELD_NAME_ORIGIN, HTTP_FIELD_TYPE_STR, "origin" },
+        { HTTP_FIELD_NAME_ACCESS_CONTROL_REQUEST_METHOD, HTTP_FIELD_TYPE_STR,
+            "access-control-request-method" },
+        { HTTP_FIELD_NAME_ACCESS_CONTROL_REQUEST_HEADERS, HTTP_FIELD_TYPE_STR,
+            "access-control-request-headers" },
+        { HTTP_FIELD_NAME_ACCESS_CONTROL_ALLOW_ORIGIN, HTTP_FIELD_TYPE_STR,
+            "access-control-allow-origin" },
+        { HTTP_FIELD_NAME_ACCESS_CONTROL_ALLOW_METHODS, HTTP_FIELD_TYPE_STR,
+            "access-control-allow-methods" },
+        { HTTP_FIELD_NAME_ACCESS_CONTROL_ALLOW_HEADERS, HTTP_FIELD_TYPE_STR,
+            "access-control-allow-headers" },
+        { HTTP_FIELD_NAME_UPGRADE, HTTP_FIELD_TYPE_STR, "Upgrade"},
+        { HTTP_FIELD_NAME_SEC_WS_KEY, HTTP_FIELD_TYPE_STR,
+            "Sec-WebSocket-Key" },
+        { HTTP_FIELD_NAME_SEC_WS_PROTOCOL, HTTP_FIELD_TYPE_STR,
+            "Sec-WebSocket-Protocol" },
+        { HTTP_FIELD_NAME_SEC_WS_VERSION, HTTP_FIELD_TYPE_INT,
+            "Sec-WebSocket-Version" },
+        { HTTP_FIELD_NAME_SEC_WS_ACCEPT, HTTP_FIELD_TYPE_STR,
+            "Sec-WebSocket-Accept" },
+    };
+
+    /* sanity check */
+    assert(!(name && str), "only one thing can be specified");
+    assert(name || str, "at least one thing must be specified");
+
+    /* look for the entry in the lut */
+    for (l = lut; l != lut + elems(lut); l++) {
+        /* matching by name */
+        if (name && l->name == name)
+            return l;
+        /* matching by name string */
+        if (str && strncicmp(l->str, str, strlen(l->str)) == 0)
+            return l;
+    }
+    /* did not find anything */
+    return 0;
+}
+
+/* get status code specification */
+const uhttp_status_code_spec_t * UHTTPSrv_GetStatusCodeSpec(
+    enum uhttp_status_code code, const char *msg)
+{
+    /* list of supported field types and their parsers */
+    static const uhttp_status_code_spec_t *l, lut[] = {
+        { HTTP_STATUS_200_OK, 200, "OK" },
+        { HTTP_STATUS_101_SWITCHING_PROTOCOLS, 101, "Switching Protocols" },
+        { HTTP_STATUS_400_BAD_REQUEST, 400, "Bad Request" },
+        { HTTP_STATUS_404_NOT_FOUND, 404, "Not Found" },
+        { HTTP_STATUS_405_METHOD_NOT_ALLOWED, 405, "Method Not Allowed" },
+        { HTTP_STATUS_500_INTERNAL_SRV_ERR, 500, "Internal Server Error" },
+    };
+
+    /* sanity check */
+    assert(!(code && msg), "only one thing can be specified");
+    assert(code || msg, "at least one thing must be specified");
+
+    /* look for the entry in the lut */
+    for (l = lut; l != lut + elems(lut); l++) {
+        /* matching by code */
+        if (code && l->code == code)
+            return l;
+        /* matching by name string */
+        if (msg && strncicmp(l->msg, msg, strlen(l->msg)) == 0)
+            return l;
+    }
+    /* did not find anything */
+    return 0;
+}
+
+/* parse the request line from the server */
+err_t UHTTPSrv_ParseRequestLine(const char *line, size_t line_len,
+    enum uhttp_method *method, char *url, size_t url_size,
+    enum uhttp_version *version)
+{
+    /* placeholders */
+    char method_str[10], version_str[10];
+    /* scan the line, it should be splittable into three substrings separated by
+     * space: method url version */
+    if (snscanf(line, line_len, "%.*s %.*s %.*s",
+        sizeof(method_str) - 1, method_str, url_size, url,
+        sizeof(version_str) - 1, version_str ) != 3)
+        return EARGVAL;
+
+
+    /* parse the method */
+    const uhttp_method_spec_t *m_spec = UHTTPSrv_GetMethodSpec(0, method_str);
+    /* unable to parse method */
+    if (!m_spec)
+        return EFATAL;
+
+    /* parse the version */
+    const uhttp_version_spec_t *v_spec = UHTTPSrv_GetVersionSpec(0, version_str);
+    /* unable to parse version */
+    if (!v_spec)
+        return EFATAL;
+
+    /* store data */
+    *method = m_spec->method;
+    *version = v_spec->version;
+
+    /* return the status of parsing */
+    return EOK;
+}
+
+/* try to parse a line as it is a field value: "field: value" */
+err_t UHTTPSrv_ParseFieldLine(const char *line, size_t line_len,
+    uhttp_field_t *field)
+{
+    /* pointer to where the value starts */
+    const char *vptr;
+
+    /* go across the field name until you meet ':' or eol (which is an error) */
+    for (vptr = line; vptr < line + line_len && *vptr && *vptr != ':'; vptr++);
+    /* if it does not end with ':' then we have a problem */
+    if (*vptr != ':')
+        goto fail;
+
+    /* store the length of the name string */
+    size_t name_str_len = (vptr - line);
+    /*.. and move the ':' and the whitespaces */
+    for (vptr = vptr + 1; vptr < line + line_len && isspace(*vptr); vptr++);
+
+    /* store the value size */
+    size_t vsize = line_len - (vptr - line);
+
+    /* if the field is known then we'll fill that information later on */
+    field->name = HTTP_FIELD_NAME_UNKNOWN;
+    /* store the sizes */
+    field->name_str = line; field->name_str_len = name_str_len;
+
+    /* try to locate the field specification in the data-base */
+    const uhttp_field_spec_t *fs = UHTTPSrv_GetFieldSpec(0, line);
+    /* unknown field */
+    if (!fs)
+        goto unknown;
+
+     /* conversion ok flag */
+    int conv_ok = 0; union uhttp_field_value fv;
+    /* parse the value */
+    switch (fs->type) {
+    /* integers and floats are dealt with snscanf */
+    case HTTP_FIELD_TYPE_INT:
+        conv_ok = snscanf(vptr, vsize, "%i", &fv.i) == 1; break;
+    case HTTP_FIELD_TYPE_FLOAT:
+        conv_ok = snscanf(vptr, vsize, "%a", &fv.f) == 1; break;
+    /* strings are just pointed to, they are not copied */
+    case HTTP_FIELD_TYPE_STR:
+        conv_ok = 1; fv.s = vptr; break;
+    /* unsupported conversion */
+    default: assert(0, "unsupported converter");
+    }
+    /* conversion succeded? */
+    if (!conv_ok)
+        goto fail;
+
+    /* store the data */
+    field->name = fs->name; memcpy(&field->value, &fv, sizeof(fv));
+    /* report success */
+    return EOK;
+
+    /* properly syntaxed but unknown parameters go here */
+    unknown: {
+        /* since we are here then it means that we were not able to parse
+        * the parameter. let's just simply store the string value */
+        field->value.s = vptr;
+        /* could not parse the field */
+        return EOK;
+    }
+
+    /* improper syntax lines go here */
+    fail: {
+        return EFATAL;
+    }
+}
+
+/* render field's value to the output string */
+err_t UHTTPSrv_RenderFieldLine(char *out, size_t size,
+    enum uhttp_field_name name, va_list args)
+{
+    /* error code */
+    err_t ec;
+    /* get the field specification */
+    const uhttp_field_spec_t *fs = UHTTPSrv_GetFieldSpec(name, 0);
+
+    /* unknown field */
+    if (!fs)
+        return EFATAL;
+
+    /* get the field formatter */
+    switch (fs->type) {
+    case HTTP_FIELD_TYPE_INT: {
+        ec = snprintf(out, size, "%s: %i\r\n", fs->str, va_arg(args, int));
+    } break;
+    case HTTP_FIELD_TYPE_FLOAT: {
+        ec = snprintf(out, size, "%s: %f\r\n", fs->str, va_arg(args, double));
+    } break;
+    case HTTP_FIELD_TYPE_STR: {
+        ec = snprintf(out, size, "%s: %s\r\n", fs->str, va_arg(args, char *));
+    } break;
+    /* complain */
+    default: assert(0, "unsupported type");
+    }
+
+    /* return the size of the sentence being rendered */
+    return ec;
+}
@@ -204,6 +204,9 @@ typedef struct uhttp_instance {
     dtime_t timeout;
     /* maximal number of simultaneous connections */
     int max_connections;
+    /* listening socket shared by all serving tasks (set up by the
+     * UHTTPSrv_InstanceInit() when the 'accept' function is in use) */
+    void *lsock;
     /* stack size for the serving task */
     size_t stack_size;
     /* callback function */
@@ -215,6 +218,13 @@ typedef struct uhttp_instance {
         void* (*create) (void);
         /* start listening on given port */
         err_t (*listen) (void *sock, int port);
+        /* create the socket that listens on given port on behalf of all
+         * serving tasks and handles up to 'num' connections at once. used
+         * together with 'accept' instead of 'create' and 'listen' */
+        void* (*listener) (int port, int num);
+        /* wait for the connection on the listening socket and return the
+         * connected socket */
+        void* (*accept) (void *lsock, int port);
         /* receive data from the socket */
         err_t (*recv) (void *sock, void *ptr, size_t size, dtime_t timeout);
         /* send data through the socket */
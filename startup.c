@@ -30,8 +30,10 @@ static int Startup_IsJumpAddressValid(void)
     return startup_jump_address[0] == ~startup_jump_address[1];
 }
 
-/* copy a memory section */
-static void Startup_CopySection(void *dst, const void *src, size_t size)
+/* copy a memory section. the compiler must not turn the loop into memcpy()
+ * call since memcpy() itself lives in ram that is not yet initialized */
+static void OPTIMIZE("no-tree-loop-distribute-patterns") Startup_CopySection(
+    void *dst, const void *src, size_t size)
 {
     /* destination and source pointer */
     uint8_t *d = dst; const uint8_t *s = src;
@@ -48,8 +50,9 @@ static void Startup_CopySection(void *dst, const void *src, size_t size)
     }
 }
 
-/* clear a memory section */
-static void Startup_ZeroSection(void *ptr, size_t size)
+/* clear a memory section (no memset() calls, see above) */
+static void OPTIMIZE("no-tree-loop-distribute-patterns") Startup_ZeroSection(
+    void *ptr, size_t size)
 {
     /* zeroing pointer */
     uint8_t *p = ptr;
@@ -0,0 +1,52 @@
+/**
+ * @file dwt.h
+ * @author Tomasz Watorowski (tomasz.watorowski@gmail.com)
+ * @date 2025-04-20
+ *
+ * @copyright Copyright (c) 2025
+ */
+
+#ifndef STM32F401_DWT_H
+#define STM32F401_DWT_H
+
+
+#include "stm32f401.h"
+
+/* base addresses */
+#define DWT_BASE                                            (0xE0001000)
+#define DCB_BASE                                            (0xE000EDF0)
+
+/* instances */
+#define DWT                                                 ((dwt_t *)DWT_BASE)
+#define DCB                                                 ((dcb_t *)DCB_BASE)
+
+/* data watchpoint and trace register bank */
+typedef struct {
+    reg32_t CTRL;
+    reg32_t CYCCNT;
+    reg32_t CPICNT;
+    reg32_t EXCCNT;
+    reg32_t SLEEPCNT;
+    reg32_t LSUCNT;
+    reg32_t FOLDCNT;
+    reg32_t PCSR;
+} dwt_t;
+
+/* debug control block register bank */
+typedef struct {
+    reg32_t DHCSR;
+    reg32_t DCRSR;
+    reg32_t DCRDR;
+    reg32_t DEMCR;
+} dcb_t;
+
+
+/* DWT Control Register Definitions */
+#define DWT_CTRL_NOCYCCNT                                   0x02000000
+#define DWT_CTRL_CYCCNTENA                                  0x00000001
+
+/* Debug Exception and Monitor Control Register Definitions */
+#define DCB_DEMCR_TRCENA                                    0x01000000
+
+
+#endif /* STM32F401_DWT_H */
@@ -23,23 +23,41 @@ typedef void (*cb_t) (void *);
 typedef struct ev_listener {
     /* listener task */
     uint32_t task_id;
-    /* id of an event when we started to listen */
-    uint32_t ev_id;
     /* the event itself */
     struct ev *ev;
+    /* mailbox with the pending events */
+    struct ev_mbox {
+        /* event call id */
+        uint32_t id;
+        /* argument that was passed to Ev_Notify() or the copy below */
+        void *arg;
+        /* copy of the argument (for events with arg_size set) */
+        void *copy[SYS_EV_ARG_SIZE / sizeof(void *)];
+    } mbox[SYS_EV_LISTENER_QUEUE_SIZE];
+    /* mailbox put/get counters */
+    uint32_t head, tail;
+    /* the oldest event from the mailbox was captured */
+    int captured;
+    /* number of events that were lost due to the mailbox being full */
+    uint32_t overruns;
 } ev_listener_t;
 
 /** callback based event */
 typedef struct ev {
     /* current callback argument */
     void *arg;
+    /** size of the argument that is copied into the mailboxes of the
+     * listeners (0 - only the pointer is passed) */
+    size_t arg_size;
     /* event call id */
     uint32_t id;
     /** array of callback */
 	cb_t cb[SYS_EV_MAX_CBS];
 
     /* all the listeners */
-    ev_listener_t listeners[4];
+    ev_listener_t listeners[SYS_EV_MAX_LISTENERS];
+    /* total number of events lost by all of the listeners */
+    uint32_t overruns;
 } ev_t;
 
 /**
@@ -64,7 +82,14 @@ err_t Ev_Subscribe(ev_t *event, cb_t callback);
 err_t Ev_Unsubscribe(ev_t *event, cb_t callback);
 
 /**
- * @brief notify the listeners of event that occured
+ * @brief notify the listeners of event that occured. Callbacks are called
+ * right away, listeners get the event put into their mailboxes and this
+ * function returns without waiting for them to process it. Events with
+ * 'arg_size' set have the argument copied into the mailbox (listeners get the
+ * pointer to the copy), for the others the argument must remain valid until
+ * all of the listeners have acked the event.
+ * Listeners with full mailboxes do not get the event and have their overrun
+ * counters increased.
  *
  * @param event event to be triggered
  * @param arg argument to be passed to all of the listeners and awaiters
@@ -91,7 +116,7 @@ err_t Ev_Wait(ev_t *event, dtime_t timeout);
 ev_listener_t * Ev_Listen(ev_t *event);
 
 /**
- * @brief wait and capture the event that we are listening to
+ * @brief wait and capture the oldest event from the listener's mailbox
  *
  * @param lst listener descriptor
  * @param arg pointer to which we will store the pointer to event's argument
@@ -102,13 +127,24 @@ ev_listener_t * Ev_Listen(ev_t *event);
 err_t Ev_Capture(ev_listener_t *lst, void **arg, dtime_t timeout);
 
 /**
- * @brief ack the event that was captured. After acking the pointer to the
- * argument that user got with Ev_Capture is no longer valid
+ * @brief ack the event that was captured and remove it from the mailbox. After
+ * acking the pointer to the argument that user got with Ev_Capture is no
+ * longer valid. Does nothing if no event was captured.
  *
  * @param lst listener descriptor
 **/
 void Ev_Ack(ev_listener_t *lst);
 
+/**
+ * @brief get the number of events that were lost by the listener since it
+ * started listening due to its mailbox being full
+ *
+ * @param lst listener descriptor
+ *
+ * @return uint32_t number of lost events
+**/
+static inline uint32_t Ev_GetOverruns(ev_listener_t *lst) { return lst->overruns; }
+
 /**
  * @brief stop listening to an event
  *
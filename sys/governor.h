@@ -0,0 +1,51 @@
+/**
+ * @file governor.h
+ *
+ * @author Tomasz Watorowski (tomasz.watorowski@gmail.com)
+ * @date 2025-04-24
+ *
+ * @brief Clock governor policy: decides on the clock level based on the load
+ * measured by the scheduler. Every level halves the clock of the previous
+ * one. The clock goes straight to the maximum when the load is high and is
+ * lowered one level at the time when the load predicted for the lower clock
+ * stays low for a couple of periods. Pure logic, no hardware access.
+ */
+
+#ifndef SYS_GOVERNOR_H
+#define SYS_GOVERNOR_H
+
+#include <stdint.h>
+
+/** governor state */
+typedef struct governor {
+    /* current level (0 - the fastest one) and the number of levels */
+    int level, levels;
+    /* number of consecutive periods with the load low enough to go down */
+    int calm;
+} governor_t;
+
+/**
+ * @brief initialize the governor state
+ *
+ * @param g governor state
+ * @param levels number of available clock levels
+ */
+static inline void Governor_Init(governor_t *g, int levels)
+{
+    /* start at full speed */
+    g->level = 0, g->levels = levels, g->calm = 0;
+}
+
+/**
+ * @brief decide on the clock level given the load measured during the last
+ * period (at current level)
+ *
+ * @param g governor state
+ * @param busy number of busy cycles
+ * @param total number of all cycles
+ *
+ * @return int clock level to be used during the next period
+ */
+int Governor_Decide(governor_t *g, uint32_t busy, uint32_t total);
+
+#endif /* SYS_GOVERNOR_H */
@@ -17,9 +17,12 @@
 /**
  * @brief Initialize dynamic memory allocation
  * 
+ * @param ptr heap memory (8-byte aligned)
+ * @param size size of the heap memory (multiple of 8)
+ *
  * @return err_t error code
  */
-err_t Heap_Init(void);
+err_t Heap_Init(void *ptr, size_t size);
 
 /**
  * @brief  Allocate a block of memory
@@ -0,0 +1,121 @@
+/**
+ * @file msgq.h
+ *
+ * @author Tomasz Watorowski (tomasz.watorowski@gmail.com)
+ * @date 2025-04-08
+ *
+ * @brief Message queue: variable length records (optional header + payload)
+ * stored in a byte queue and prefixed with their length.
+ */
+
+#ifndef SYS_MSGQ_H
+#define SYS_MSGQ_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "err.h"
+#include "sys/queue.h"
+#include "sys/time.h"
+
+/** message queue block */
+typedef struct msgq {
+    /* underlying byte queue */
+    queue_t *q;
+    /* number of records stored */
+    size_t count;
+} msgq_t;
+
+/**
+ * @brief Allocate memory for the message queue
+ *
+ * @param size capacity in bytes (every record takes additional
+ * sizeof(size_t) bytes for the length prefix)
+ *
+ * @return msgq_t * queue descriptor pointer or null if no memory is available
+ */
+msgq_t * MsgQ_Create(size_t size);
+
+/**
+ * @brief Frees the memory used by the message queue
+ *
+ * @param mq queue descriptor pointer
+ */
+void MsgQ_Destroy(msgq_t *mq);
+
+/**
+ * @brief Returns the number of records stored within the queue
+ *
+ * @param mq queue descriptor pointer
+ *
+ * @return size_t number of records
+ */
+size_t MsgQ_GetCount(msgq_t *mq);
+
+/**
+ * @brief Store a record made of the header and the payload. Either the whole
+ * record is stored or nothing is.
+ *
+ * @param mq queue descriptor pointer
+ * @param hdr header pointer (may be null if hdr_size is 0)
+ * @param hdr_size header size
+ * @param ptr payload pointer
+ * @param size payload size
+ *
+ * @return err_t EOK if record was stored, EBUSY if there was not enough space
+ */
+err_t MsgQ_Put(msgq_t *mq, const void *hdr, size_t hdr_size, const void *ptr,
+    size_t size);
+
+/**
+ * @brief Get the zero-copy view of the next record. Record stays within the
+ * queue until MsgQ_Drop() is called.
+ *
+ * @param mq queue descriptor pointer
+ * @param span placeholder for the view of the record (header + payload)
+ *
+ * @return err_t record size (header + payload) or EAGAIN if queue is empty
+ */
+err_t MsgQ_Peek(msgq_t *mq, queue_span_t *span);
+
+/**
+ * @brief Drop the next record
+ *
+ * @param mq queue descriptor pointer
+ *
+ * @return err_t EOK or EAGAIN if queue is empty
+ */
+err_t MsgQ_Drop(msgq_t *mq);
+
+/**
+ * @brief Dequeue the whole record. Header is copied to 'hdr', payload is
+ * copied to 'ptr' and truncated to 'size' bytes if the buffer is too small.
+ * The record is always removed as a whole.
+ *
+ * @param mq queue descriptor pointer
+ * @param hdr placeholder for the header
+ * @param hdr_size header size
+ * @param ptr placeholder for the payload
+ * @param size size of the payload buffer
+ *
+ * @return err_t number of payload bytes copied, EAGAIN if queue is empty or
+ * EARGVAL if the header is larger than the record (record is not removed)
+ */
+err_t MsgQ_Get(msgq_t *mq, void *hdr, size_t hdr_size, void *ptr, size_t size);
+
+/**
+ * @brief Wait for the record to arrive and dequeue it (see MsgQ_Get())
+ *
+ * @param mq queue descriptor pointer
+ * @param hdr placeholder for the header
+ * @param hdr_size header size
+ * @param ptr placeholder for the payload
+ * @param size size of the payload buffer
+ * @param timeout timeout in ms (0 - wait forever)
+ *
+ * @return err_t number of payload bytes copied, ETIMEOUT or ECANCEL
+ */
+err_t MsgQ_GetWait(msgq_t *mq, void *hdr, size_t hdr_size, void *ptr,
+    size_t size, dtime_t timeout);
+
+#endif /* SYS_MSGQ_H */
@@ -0,0 +1,80 @@
+/**
+ * @file mutex.h
+ *
+ * @author Tomasz Watorowski (tomasz.watorowski@gmail.com)
+ * @date 2025-04-12
+ *
+ * @brief Fair mutex: waiters are queued in FIFO order and the ownership is
+ * handed over directly to the longest waiting task upon release.
+ */
+
+#ifndef SYS_MUTEX_H
+#define SYS_MUTEX_H
+
+#include "err.h"
+#include "compiler.h"
+#include "sys/time.h"
+
+/** waiter record, lives on the stack of the waiting task */
+typedef struct mutex_waiter {
+    /* next waiter in the queue */
+    struct mutex_waiter *next;
+    /* waiting task */
+    int task_id;
+    /* set by the releasing task when the ownership was handed over */
+    volatile int granted;
+} mutex_waiter_t;
+
+/** mutex */
+typedef struct mutex {
+    /* owner task id (0 - mutex is released) */
+    int owner;
+    /* number of times the owner has locked the mutex */
+    int depth;
+    /* queue of waiters */
+    mutex_waiter_t *head, *tail;
+} mutex_t;
+
+/** initializer for the statically allocated mutexes */
+#define MUTEX_RELEASED                              { 0 }
+
+/** macro for doing an operation with a mutex locked */
+#define with_mutex(m)                                                       \
+    for (mutex_t * CLEANUP(with_mutex_cleanup) __mutex =                    \
+            (Mutex_Lock((m), 0), (m)), * __once = __mutex;                  \
+         __once; __once = 0)
+
+/**
+ * @brief Lock the mutex. If it's owned by other task then the caller is put at
+ * the end of the waiters queue. Mutex may be locked recursively by the owner.
+ *
+ * @param m mutex
+ * @param timeout locking timeout (0 - wait forever)
+ *
+ * @return err_t EOK or ETIMEOUT
+ */
+err_t Mutex_Lock(mutex_t *m, dtime_t timeout);
+
+/**
+ * @brief Try to lock the mutex without waiting
+ *
+ * @param m mutex
+ *
+ * @return err_t EOK or EBUSY
+ */
+err_t Mutex_TryLock(mutex_t *m);
+
+/**
+ * @brief Release the mutex. When the last recursive lock is released the
+ * ownership goes directly to the first waiter in the queue.
+ *
+ * @param m mutex
+ *
+ * @return err_t EOK or EARGVAL when the caller does not own the mutex
+ */
+err_t Mutex_Release(mutex_t *m);
+
+/* cleanup routine for the with_mutex macro */
+static inline void with_mutex_cleanup(mutex_t **m) { Mutex_Release(*m); }
+
+#endif /* SYS_MUTEX_H */
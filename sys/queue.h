@@ -28,10 +28,25 @@ typedef struct queue {
     size_t head;
     /** tail counter */
     size_t tail;
+    /** highest number of used elements observed (high-water mark) */
+    size_t hwm;
     /* guarding semaphoer */
     sem_t sem;
 } queue_t;
 
+/** view of the queue memory region that may wrap around the end of the
+ * buffer: 1st segment starts at the head/tail, 2nd one (if not empty) always
+ * starts at the beginning of the buffer */
+typedef struct queue_span {
+    /* segments of the region */
+    struct {
+        /* pointer to the segment memory */
+        void *ptr;
+        /* number of elements within the segment */
+        size_t count;
+    } seg[2];
+} queue_span_t;
+
 /**
  * @brief Allocate memory for the queue and initialize it's contents
  *
@@ -98,6 +113,52 @@ size_t Queue_DropAll(queue_t *q);
  */
 size_t Queue_IncreaseCount(queue_t *q, size_t count);
 
+/**
+ * @brief Reserve up to 'count' free elements for writing in place. Memory
+ * described by the span can be filled directly and then made visible to the
+ * consumer with Queue_Commit(). Nothing is enqueued until commit is called.
+ *
+ * @param q queue descriptor pointer
+ * @param count maximal number of elements to reserve
+ * @param span placeholder for the (possibly wrapped) free memory region
+ *
+ * @return size_t number of elements reserved (sum of both segments)
+ */
+size_t Queue_Reserve(queue_t *q, size_t count, queue_span_t *span);
+
+/**
+ * @brief Commit elements that were written in place after Queue_Reserve()
+ *
+ * @param q queue descriptor pointer
+ * @param count number of elements to commit
+ *
+ * @return size_t actual number of elements committed
+ */
+size_t Queue_Commit(queue_t *q, size_t count);
+
+/**
+ * @brief Get the view of up to 'count' used elements without copying them.
+ * Elements stay in the queue until they are released with Queue_Consume().
+ *
+ * @param q queue descriptor pointer
+ * @param count maximal number of elements to look at
+ * @param span placeholder for the (possibly wrapped) used memory region
+ *
+ * @return size_t number of elements available in the span
+ */
+size_t Queue_PeekLinear(queue_t *q, size_t count, queue_span_t *span);
+
+/**
+ * @brief Release elements that were processed in place after
+ * Queue_PeekLinear()
+ *
+ * @param q queue descriptor pointer
+ * @param count number of elements to release
+ *
+ * @return size_t actual number of elements released
+ */
+size_t Queue_Consume(queue_t *q, size_t count);
+
 /**
  * @brief Writes elements to the queue. As many as can be written at given
  * moment.
@@ -123,6 +184,21 @@ size_t Queue_Put(queue_t *q, const void *ptr, size_t count);
  */
 size_t Queue_PutWait(queue_t *q, const void *ptr, size_t count, dtime_t timeout);
 
+/**
+ * @brief Write elements into the free space of the queue 'offs' elements
+ * after the head without enqueuing them. Data becomes visible to the consumer
+ * once the gap before it is filled with Queue_Put() and the elements are
+ * committed with Queue_Commit().
+ *
+ * @param q queue descriptor pointer
+ * @param offs number of free elements to skip
+ * @param ptr pointer to the data to be written
+ * @param count number of elements to be written
+ *
+ * @return size_t actual number of elements written (limited by free space)
+ */
+size_t Queue_PutAt(queue_t *q, size_t offs, const void *ptr, size_t count);
+
 /**
  * @brief read the data from the queue but do not drop it afterwards.
  *
@@ -134,6 +210,19 @@ size_t Queue_PutWait(queue_t *q, const void *ptr, size_t count, dtime_t timeout)
  */
 size_t Queue_Peek(queue_t *q, void *ptr, size_t count);
 
+/**
+ * @brief read the data from the queue starting 'offs' elements after the
+ * tail but do not drop it afterwards.
+ *
+ * @param q queue descriptor pointer
+ * @param offs number of elements to skip
+ * @param ptr pointer to the data to be written
+ * @param count maximal number of elements to be read
+ *
+ * @return size_t actual number of elements read
+ */
+size_t Queue_PeekAt(queue_t *q, size_t offs, void *ptr, size_t count);
+
 /**
  * @brief Read the data from the queue and drop it afterwards.
  *
@@ -159,6 +248,55 @@ size_t Queue_Get(queue_t *q, void *ptr, size_t count);
  */
 size_t Queue_GetWait(queue_t *q, void *ptr, size_t count, dtime_t time);
 
+/**
+ * @brief Wait until at least 'level' elements are stored in the queue or the
+ * timeout elapses, whichever comes first. Does not touch the data so that the
+ * consumer can drain the whole batch in one go afterwards. Scheduler is
+ * cooperative and has no notion of blocked tasks, so the caller is still
+ * woken on every Yield() to check the fill level: this saves the per-wakeup
+ * copying and the processing of small chunks, not the wakeups themselves.
+ *
+ * @param q queue descriptor pointer
+ * @param level number of elements to wait for (limited to queue capacity)
+ * @param timeout max latency in ms (0 - wait forever)
+ *
+ * @return size_t number of elements stored within the queue upon return
+ */
+size_t Queue_WaitLevel(queue_t *q, size_t level, dtime_t timeout);
+
+/**
+ * @brief Batched read: wait until 'level' elements are available or the
+ * max latency elapses and then read as much as possible (up to 'count')
+ * in a single go.
+ *
+ * @param q queue descriptor pointer
+ * @param ptr pointer to where to store the data
+ * @param level number of elements that triggers the read
+ * @param count maximal number of elements to be read
+ * @param timeout max latency in ms (0 - wait forever)
+ *
+ * @return size_t actual number of elements read
+ */
+size_t Queue_GetBatchWait(queue_t *q, void *ptr, size_t level, size_t count,
+    dtime_t timeout);
+
+/**
+ * @brief Returns the highest fill level that the queue has ever reached
+ * (since creation or last reset).
+ *
+ * @param q queue descriptor pointer
+ *
+ * @return size_t high-water mark expressed in elements
+ */
+size_t Queue_GetHighWatermark(queue_t *q);
+
+/**
+ * @brief Reset the high-water mark to the current fill level
+ *
+ * @param q queue descriptor pointer
+ */
+void Queue_ResetHighWatermark(queue_t *q);
+
 /**
  * @brief get the pointer to the linear memory where you can
  * store the data.
@@ -0,0 +1,97 @@
+/**
+ * @file rwlock.h
+ *
+ * @author Tomasz Watorowski (tomasz.watorowski@gmail.com)
+ * @date 2025-04-12
+ *
+ * @brief Fair reader-writer lock: many readers or a single writer. Waiters
+ * are served in FIFO order so that neither readers nor writers starve.
+ */
+
+#ifndef SYS_RWLOCK_H
+#define SYS_RWLOCK_H
+
+#include "err.h"
+#include "compiler.h"
+#include "sys/time.h"
+
+/** waiter record, lives on the stack of the waiting task */
+typedef struct rwlock_waiter {
+    /* next waiter in the queue */
+    struct rwlock_waiter *next;
+    /* waiting task, does it want to write? */
+    int task_id, write;
+    /* set by the releasing task when the lock was handed over */
+    volatile int granted;
+} rwlock_waiter_t;
+
+/** reader-writer lock */
+typedef struct rwlock {
+    /* task id of the writer (0 - no writer) */
+    int writer;
+    /* number of readers holding the lock */
+    int readers;
+    /* queue of waiters */
+    rwlock_waiter_t *head, *tail;
+} rwlock_t;
+
+/** initializer for the statically allocated locks */
+#define RWLOCK_RELEASED                             { 0 }
+
+/** macro for doing an operation with the lock held for reading */
+#define with_rwlock_read(l)                                                 \
+    for (rwlock_t * CLEANUP(with_rwlock_read_cleanup) __rwlock =            \
+            (RWLock_LockRead((l), 0), (l)), * __once = __rwlock;            \
+         __once; __once = 0)
+
+/** macro for doing an operation with the lock held for writing */
+#define with_rwlock_write(l)                                                \
+    for (rwlock_t * CLEANUP(with_rwlock_write_cleanup) __rwlock =           \
+            (RWLock_LockWrite((l), 0), (l)), * __once = __rwlock;           \
+         __once; __once = 0)
+
+/**
+ * @brief Lock for reading. Not recursive.
+ *
+ * @param l lock
+ * @param timeout locking timeout (0 - wait forever)
+ *
+ * @return err_t EOK or ETIMEOUT
+ */
+err_t RWLock_LockRead(rwlock_t *l, dtime_t timeout);
+
+/**
+ * @brief Lock for writing. Not recursive.
+ *
+ * @param l lock
+ * @param timeout locking timeout (0 - wait forever)
+ *
+ * @return err_t EOK or ETIMEOUT
+ */
+err_t RWLock_LockWrite(rwlock_t *l, dtime_t timeout);
+
+/**
+ * @brief Release the read lock
+ *
+ * @param l lock
+ *
+ * @return err_t EOK or EARGVAL if lock was not held for reading
+ */
+err_t RWLock_ReleaseRead(rwlock_t *l);
+
+/**
+ * @brief Release the write lock
+ *
+ * @param l lock
+ *
+ * @return err_t EOK or EARGVAL if caller is not the writer
+ */
+err_t RWLock_ReleaseWrite(rwlock_t *l);
+
+/* cleanup routines for the with_rwlock_* macros */
+static inline void with_rwlock_read_cleanup(rwlock_t **l)
+    { RWLock_ReleaseRead(*l); }
+static inline void with_rwlock_write_cleanup(rwlock_t **l)
+    { RWLock_ReleaseWrite(*l); }
+
+#endif /* SYS_RWLOCK_H */
@@ -0,0 +1,136 @@
+/**
+ * @file spsc.h
+ *
+ * @author Tomasz Watorowski (tomasz.watorowski@gmail.com)
+ * @date 2025-04-02
+ *
+ * @brief Lock-free single producer, single consumer queue. Producer may be an
+ * interrupt routine while the consumer is a task (or the other way around).
+ */
+
+#ifndef SYS_SPSC_H
+#define SYS_SPSC_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "err.h"
+#include "sys/time.h"
+
+/** callback invoked (in producer's context) after data was put */
+typedef void (* spsc_cb_t)(void *arg);
+
+/** spsc queue block */
+typedef struct spsc {
+    /* size of the single element */
+    size_t size;
+    /* number of elements that can fit into the buffer */
+    uint32_t count;
+    /** pointer to queue buffer, byte-wise */
+    uint8_t *ptr;
+    /** head counter, written by the producer only */
+    volatile uint32_t head;
+    /** tail counter, written by the consumer only */
+    volatile uint32_t tail;
+    /** optional wakeup callback and it's argument */
+    spsc_cb_t cb;
+    void *cb_arg;
+} spsc_t;
+
+/**
+ * @brief Initialize the queue over statically allocated buffer
+ *
+ * @param q queue descriptor pointer
+ * @param ptr buffer that can hold 'count' elements of size 'size'
+ * @param size size of single element
+ * @param count number of elements (power of 2, counters are free running and
+ * element indices are obtained by masking)
+ */
+void Spsc_Init(spsc_t *q, void *ptr, size_t size, uint32_t count);
+
+/**
+ * @brief Allocate memory for the queue and initialize it. Not to be called
+ * from interrupts.
+ *
+ * @param size size of single element to be placed on the queue
+ * @param count number of elements (power of 2)
+ *
+ * @return spsc_t * queue descriptor pointer or null if no memory is available
+ * or the count is not a power of 2
+ */
+spsc_t * Spsc_Create(size_t size, uint32_t count);
+
+/**
+ * @brief Frees the memory used by the queue created with Spsc_Create()
+ *
+ * @param q queue descriptor pointer
+ */
+void Spsc_Destroy(spsc_t *q);
+
+/**
+ * @brief Set the callback that is called by the producer after every
+ * successful put. Runs in producer's context so it must be interrupt-safe
+ * when the producer is an interrupt (e.g. raise a flag for the consumer).
+ *
+ * @param q queue descriptor pointer
+ * @param cb callback (0 disables the notification)
+ * @param arg callback argument
+ */
+void Spsc_SetPutCallback(spsc_t *q, spsc_cb_t cb, void *arg);
+
+/**
+ * @brief Returns the number of queue elements that are occupied
+ *
+ * @param q queue descriptor pointer
+ *
+ * @return size_t number of used queue elements
+ */
+size_t Spsc_GetUsed(spsc_t *q);
+
+/**
+ * @brief Returns the number of free elements in the queue
+ *
+ * @param q queue descriptor pointer
+ *
+ * @return size_t number of free elements
+ */
+size_t Spsc_GetFree(spsc_t *q);
+
+/**
+ * @brief Write elements to the queue (producer side). As many as can be
+ * written at given moment. Never blocks, safe to call from interrupts.
+ *
+ * @param q queue descriptor pointer
+ * @param ptr pointer to the data to be written
+ * @param count number of elements to be written
+ *
+ * @return size_t actual number of elements written
+ */
+size_t Spsc_Put(spsc_t *q, const void *ptr, size_t count);
+
+/**
+ * @brief Read elements from the queue (consumer side). Never blocks, safe to
+ * call from interrupts.
+ *
+ * @param q queue descriptor pointer
+ * @param ptr pointer to where to store the data
+ * @param count maximal number of elements to be read
+ *
+ * @return size_t actual number of elements read
+ */
+size_t Spsc_Get(spsc_t *q, void *ptr, size_t count);
+
+/**
+ * @brief Read 'count' elements from the queue, wait for the data if needed.
+ * To be called from the task context only.
+ *
+ * @param q queue descriptor pointer
+ * @param ptr pointer to where to store the data
+ * @param count number of elements to be read
+ * @param timeout read timeout in ms (0 - wait forever)
+ *
+ * @return size_t actual number of elements read
+ */
+size_t Spsc_GetWait(spsc_t *q, void *ptr, size_t count, dtime_t timeout);
+
+#endif /* SYS_SPSC_H */
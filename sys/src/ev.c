@@ -6,12 +6,18 @@
  * @copyright Copyright (c) 2024
 **/
 
+#include "assert.h"
 #include "sys/ev.h"
 #include "sys/yield.h"
 #include "util/string.h"
 #include "util/elems.h"
 #include "util/forall.h"
 
+/* mailboxes are indexed with free running counters */
+_Static_assert((SYS_EV_LISTENER_QUEUE_SIZE &
+    (SYS_EV_LISTENER_QUEUE_SIZE - 1)) == 0,
+    "listener queue size must be a power of 2");
+
 /* subscribe to any given event */
 err_t Ev_Subscribe(ev_t *event, cb_t callback)
 {
@@ -47,6 +53,8 @@ void Ev_Notify(ev_t *event, void *arg)
 {
     /* pointer to the listener entry */
     ev_listener_t *lst;
+    /* argument needs to fit into the mailbox */
+    assert(event->arg_size <= SYS_EV_ARG_SIZE, "event argument too large");
 
     /* set the argument */
     event->arg = arg;
@@ -58,16 +66,22 @@ void Ev_Notify(ev_t *event, void *arg)
         if (event->cb[i])
             event->cb[i](arg);
 
-    /* loop until all listeners have acked the reception of the event */
-    for (int all_done = 1; ; all_done = 1, Yield()) {
-        /* look for an listener that still did not finish it's job */
-        forall (lst, event->listeners)
-            if (lst->task_id != 0 && lst->ev_id != event->id) {
-                all_done = 0; break;
-            }
-        /* all listeners are done? */
-        if (all_done)
-            break;
+    /* put the event into the mailboxes of all listeners */
+    forall (lst, event->listeners) {
+        /* unused entry */
+        if (lst->task_id == 0)
+            continue;
+        /* mailbox is full, listener is too slow */
+        if (lst->head - lst->tail == elems(lst->mbox)) {
+            lst->overruns++, event->overruns++; continue;
+        }
+        /* mailbox entry */
+        struct ev_mbox *m = &lst->mbox[lst->head % elems(lst->mbox)];
+        /* store the event, argument gets copied if the event asks for it */
+        m->id = event->id, m->arg = arg;
+        if (event->arg_size && arg)
+            m->arg = memcpy(m->copy, arg, event->arg_size);
+        lst->head++;
     }
 }
 
@@ -102,8 +116,11 @@ ev_listener_t * Ev_Listen(ev_t *event)
 
     /* store information about the listener */
     lst->task_id = Yield_GetTaskID();
-    lst->ev_id = event->id;
     lst->ev = event;
+    /* start with an empty mailbox */
+    lst->head = lst->tail = 0;
+    lst->captured = 0;
+    lst->overruns = 0;
 
     /* report success */
     return lst;
@@ -112,13 +129,15 @@ ev_listener_t * Ev_Listen(ev_t *event)
 /* receive an event during listening */
 err_t Ev_Capture(ev_listener_t *lst, void **arg, dtime_t timeout)
 {
-    /* wait as long as the event id is not equal to id */
-    for (time_t ts = time(0); lst->ev->id == lst->ev_id; Yield())
+    /* wait as long as the mailbox is empty */
+    for (time_t ts = time(0); lst->head == lst->tail; Yield())
         if (timeout && dtime_now(ts) > timeout)
             return ETIMEOUT;
     /* return the event argument */
     if (arg)
-        *arg = lst->ev->arg;
+        *arg = lst->mbox[lst->tail % elems(lst->mbox)].arg;
+    /* mark as captured so that the ack will remove it from the mailbox */
+    lst->captured = 1;
 
     /* return the success code */
     return EOK;
@@ -127,7 +146,9 @@ err_t Ev_Capture(ev_listener_t *lst, void **arg, dtime_t timeout)
 /* ack the event that was captured */
 void Ev_Ack(ev_listener_t *lst)
 {
-    lst->ev_id = lst->ev->id;
+    /* remove the captured event from the mailbox */
+    if (lst->captured)
+        lst->tail++, lst->captured = 0;
 }
 
 /* we are done listening */
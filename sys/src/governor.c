@@ -0,0 +1,41 @@
+/**
+ * @file governor.c
+ *
+ * @author Tomasz Watorowski (tomasz.watorowski@gmail.com)
+ * @date 2025-04-24
+ *
+ * @brief Clock governor policy
+ */
+
+#include <stdint.h>
+
+#include "config.h"
+#include "sys/governor.h"
+
+/* decide on the clock level */
+int Governor_Decide(governor_t *g, uint32_t busy, uint32_t total)
+{
+    /* nothing was measured */
+    if (!total)
+        return g->level;
+
+    /* load in permille */
+    uint32_t load = (uint64_t)busy * 1000 / total;
+
+    /* we are getting busy: go to full speed at once */
+    if (load >= GOVERNOR_UP_PERMILLE) {
+        g->level = 0, g->calm = 0;
+    /* the load would still be acceptable at half the clock */
+    } else if (g->level < g->levels - 1 &&
+        load * 2 < GOVERNOR_TARGET_PERMILLE) {
+        /* go down only after it stays that way for a while */
+        if (++g->calm >= GOVERNOR_DOWN_PERIODS)
+            g->level++, g->calm = 0;
+    /* stay where we are */
+    } else {
+        g->calm = 0;
+    }
+
+    /* return the level to be used */
+    return g->level;
+}
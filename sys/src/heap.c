@@ -28,25 +28,28 @@ typedef struct block {
     uint8_t mem[];
 } block_t;
 
-/* heap memory */
-static uint8_t ALIGNED(8) heap[SYS_HEAP_SIZE];
+/* heap memory and it's size */
+static uint8_t *heap; static size_t heap_size;
 
 /* initialize dynamic memory allocation */
-err_t Heap_Init(void)
+err_t Heap_Init(void *ptr, size_t size)
 {
     /* initiate a single block within the heap space */
-    block_t *b = (void *)heap;
+    block_t *b = ptr;
     /* pointers for marking the end of the heap */
-    uint8_t *heap_end = heap + sizeof(heap);
+    uint8_t *heap_end = (uint8_t *)ptr + size;
     /* pointer to a packed struct that represents the signature */
     struct lfb {uint32_t deadc0de; } PACKED *last_four_bytes = 
         (void *)(heap_end - sizeof(struct lfb)); 
 
     /* sanity checks */
     assert((sizeof(block_t) & 7) == 0, "block size not a multiple of 8");
-    
+    assert(((uintptr_t)ptr & 7) == 0 && (size & 7) == 0, "heap not aligned");
+
+    /* store the heap location */
+    heap = ptr, heap_size = size;
     /* setup block to */
-    b->size = sizeof(heap);
+    b->size = size;
     /* there is no next nor previous block wrt to this one */
     b->prev = 0; b->next = 0;
     /* mark as free */
@@ -73,11 +76,11 @@ void * Heap_Malloc(size_t size)
     /* go through linked list */
     for (b = (block_t *)heap; b; b = b->next) {
         /* skip over used blocks */
-        if (b->used)
+        if (b->used || b->size < size)
             continue;
         /* update best fit if there is no best fit or current best fit is much 
          * larger than currently visited block */
-        if (!best_fit || (b->size >= size && b->size < best_fit->size))
+        if (!best_fit || b->size < best_fit->size)
             /* no better match can be expected */
             if ((best_fit = b)->size == size)
                 break;
@@ -121,11 +124,21 @@ void Heap_Free(void *ptr)
     b->used = 0;
 
     /* join with next segment if it's free */
-    if ((nb = b->next) && nb->used == 0)
-        b->size += nb->size, b->next = nb->next, nb->next->prev = b;
+    if ((nb = b->next) && nb->used == 0) {
+        /* absorb the next block */
+        b->size += nb->size, b->next = nb->next;
+        /* relink the block that follows (if any) */
+        if (b->next)
+            b->next->prev = b;
+    }
     /* join with previous segment if it's free */
-    if ((pb = b->prev) && pb->used == 0)
-        pb->size += b->size, pb->next = b->next, b->next->prev = pb;
+    if ((pb = b->prev) && pb->used == 0) {
+        /* let the previous block absorb this one */
+        pb->size += b->size, pb->next = b->next;
+        /* relink the block that follows (if any) */
+        if (pb->next)
+            pb->next->prev = pb;
+    }
 }
 
 /* check the integrity of the heap */
@@ -134,7 +147,7 @@ err_t Heap_CheckIntegrity(void)
     /* pointers used during the search for the best fitting block */
     block_t *b; 
     /* pointers for marking the end of the heap */
-    uint8_t *heap_end = heap + sizeof(heap);
+    uint8_t *heap_end = heap + heap_size;
     /* pointer to a packed struct that represents the signature */
     struct lfb {uint32_t deadc0de; } PACKED *last_four_bytes = 
         (void *)(heap_end - sizeof(struct lfb)); 
@@ -0,0 +1,218 @@
+/**
+ * @file msgq.c
+ *
+ * @author Tomasz Watorowski (tomasz.watorowski@gmail.com)
+ * @date 2025-04-08
+ *
+ * @brief Message queue: variable length records
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "err.h"
+#include "sys/heap.h"
+#include "sys/msgq.h"
+#include "sys/queue.h"
+#include "sys/time.h"
+#include "sys/yield.h"
+#include "util/minmax.h"
+#include "util/string.h"
+
+/* copy data into the span at given offset */
+static void MsgQ_SpanWrite(queue_span_t *span, size_t offs, const void *src,
+    size_t size)
+{
+    /* byte-wise source pointer */
+    const uint8_t *p8 = src;
+    /* part that goes into the 1st segment */
+    size_t b_1st = offs < span->seg[0].count ?
+        min(size, span->seg[0].count - offs) : 0;
+
+    /* store the part that goes before the wrap */
+    if (b_1st)
+        memcpy((uint8_t *)span->seg[0].ptr + offs, p8, b_1st);
+    /* and the part that goes after it */
+    if (size - b_1st)
+        memcpy((uint8_t *)span->seg[1].ptr + (offs + b_1st -
+            span->seg[0].count), p8 + b_1st, size - b_1st);
+}
+
+/* copy data from the span at given offset */
+static void MsgQ_SpanRead(queue_span_t *span, size_t offs, void *dst,
+    size_t size)
+{
+    /* byte-wise destination pointer */
+    uint8_t *p8 = dst;
+    /* part that comes from the 1st segment */
+    size_t b_1st = offs < span->seg[0].count ?
+        min(size, span->seg[0].count - offs) : 0;
+
+    /* fetch the part that lies before the wrap */
+    if (b_1st)
+        memcpy(p8, (uint8_t *)span->seg[0].ptr + offs, b_1st);
+    /* and the part that lies after it */
+    if (size - b_1st)
+        memcpy(p8 + b_1st, (uint8_t *)span->seg[1].ptr + (offs + b_1st -
+            span->seg[0].count), size - b_1st);
+}
+
+/* read the length of the next record */
+static size_t MsgQ_GetRecordSize(msgq_t *mq)
+{
+    /* record size */
+    size_t size;
+    /* it's stored right at the tail */
+    Queue_Peek(mq->q, &size, sizeof(size));
+    /* return it */
+    return size;
+}
+
+/* create the message queue */
+msgq_t * MsgQ_Create(size_t size)
+{
+    /* allocate the memory for the descriptor */
+    msgq_t *mq = Heap_Malloc(sizeof(msgq_t));
+    /* unable to allocate */
+    if (!mq)
+        return 0;
+
+    /* allocate the byte queue */
+    if (!(mq->q = Queue_Create(1, size))) {
+        Heap_Free(mq); return 0;
+    }
+
+    /* queue is empty */
+    mq->count = 0;
+    /* return the pointer to the queue descriptor */
+    return mq;
+}
+
+/* release the memory */
+void MsgQ_Destroy(msgq_t *mq)
+{
+    /* free up the memory */
+    Queue_Destroy(mq->q);
+    Heap_Free(mq);
+}
+
+/* get the number of records */
+size_t MsgQ_GetCount(msgq_t *mq)
+{
+    return mq->count;
+}
+
+/* store the record */
+err_t MsgQ_Put(msgq_t *mq, const void *hdr, size_t hdr_size, const void *ptr,
+    size_t size)
+{
+    /* view of the free memory */
+    queue_span_t span;
+    /* size of the record data and the total size with the length prefix */
+    size_t rec_size = hdr_size + size, total = sizeof(rec_size) + rec_size;
+
+    /* reserve the space for the whole record */
+    if (Queue_Reserve(mq->q, total, &span) != total)
+        return EBUSY;
+
+    /* fill in the length, header and the payload */
+    MsgQ_SpanWrite(&span, 0, &rec_size, sizeof(rec_size));
+    MsgQ_SpanWrite(&span, sizeof(rec_size), hdr, hdr_size);
+    MsgQ_SpanWrite(&span, sizeof(rec_size) + hdr_size, ptr, size);
+    /* record becomes visible to the consumer all at once */
+    Queue_Commit(mq->q, total); mq->count++;
+
+    /* report success */
+    return EOK;
+}
+
+/* zero-copy view of the next record */
+err_t MsgQ_Peek(msgq_t *mq, queue_span_t *span)
+{
+    /* nothing stored */
+    if (!mq->count)
+        return EAGAIN;
+
+    /* get the length of the record */
+    size_t size = MsgQ_GetRecordSize(mq);
+    /* get the view of the length prefix + data */
+    Queue_PeekLinear(mq->q, sizeof(size) + size, span);
+
+    /* skip the length prefix */
+    if (span->seg[0].count >= sizeof(size)) {
+        span->seg[0].ptr = (uint8_t *)span->seg[0].ptr + sizeof(size);
+        span->seg[0].count -= sizeof(size);
+    /* length prefix itself was wrapped */
+    } else {
+        size_t skip = sizeof(size) - span->seg[0].count;
+        span->seg[0].ptr = (uint8_t *)span->seg[1].ptr + skip;
+        span->seg[0].count = span->seg[1].count - skip;
+        span->seg[1].count = 0;
+    }
+    /* 1st segment may be empty if the data starts exactly at the wrap */
+    if (!span->seg[0].count) {
+        span->seg[0] = span->seg[1];
+        span->seg[1].count = 0;
+    }
+
+    /* return the record size */
+    return size;
+}
+
+/* drop the next record */
+err_t MsgQ_Drop(msgq_t *mq)
+{
+    /* nothing stored */
+    if (!mq->count)
+        return EAGAIN;
+
+    /* drop the prefix and the data */
+    Queue_Drop(mq->q, sizeof(size_t) + MsgQ_GetRecordSize(mq));
+    mq->count--;
+    /* report success */
+    return EOK;
+}
+
+/* dequeue the whole record */
+err_t MsgQ_Get(msgq_t *mq, void *hdr, size_t hdr_size, void *ptr, size_t size)
+{
+    /* view of the record */
+    queue_span_t span;
+    /* get the record */
+    err_t rec_size = MsgQ_Peek(mq, &span);
+    /* no record */
+    if (rec_size < EOK)
+        return rec_size;
+    /* header larger than the record, record stays in place */
+    if (hdr_size > (size_t)rec_size)
+        return EARGVAL;
+
+    /* header is always present */
+    MsgQ_SpanRead(&span, 0, hdr, hdr_size);
+    /* limit the payload size */
+    size = min(size, rec_size - hdr_size);
+    MsgQ_SpanRead(&span, hdr_size, ptr, size);
+    /* drop the whole record */
+    MsgQ_Drop(mq);
+
+    /* return the payload size */
+    return size;
+}
+
+/* wait for the record and dequeue it */
+err_t MsgQ_GetWait(msgq_t *mq, void *hdr, size_t hdr_size, void *ptr,
+    size_t size, dtime_t timeout)
+{
+    /* wait for the record to arrive */
+    for (time_t ts = time(0); !mq->count; Yield()) {
+        /* timeout support */
+        if (timeout && dtime_now(ts) > timeout)
+            return ETIMEOUT;
+        /* cancellation support */
+        if (Yield_IsCancelled())
+            return ECANCEL;
+    }
+
+    /* get the record */
+    return MsgQ_Get(mq, hdr, hdr_size, ptr, size);
+}
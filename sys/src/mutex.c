@@ -0,0 +1,120 @@
+/**
+ * @file mutex.c
+ *
+ * @author Tomasz Watorowski (tomasz.watorowski@gmail.com)
+ * @date 2025-04-12
+ *
+ * @brief Fair mutex
+ */
+
+#include "err.h"
+#include "sys/mutex.h"
+#include "sys/time.h"
+#include "sys/yield.h"
+
+/* put the waiter at the end of the queue */
+static void Mutex_Enqueue(mutex_t *m, mutex_waiter_t *w)
+{
+    /* append */
+    if (m->tail) {
+        m->tail->next = w;
+    } else {
+        m->head = w;
+    }
+    /* update the tail */
+    m->tail = w;
+}
+
+/* remove the waiter from the queue */
+static void Mutex_Remove(mutex_t *m, mutex_waiter_t *w)
+{
+    /* previous element */
+    mutex_waiter_t *prev = 0;
+    /* look for the waiter */
+    for (mutex_waiter_t *p = m->head; p; prev = p, p = p->next) {
+        if (p != w)
+            continue;
+        /* unlink */
+        if (prev) {
+            prev->next = w->next;
+        } else {
+            m->head = w->next;
+        }
+        /* update the tail */
+        if (m->tail == w)
+            m->tail = prev;
+        break;
+    }
+}
+
+/* lock the mutex */
+err_t Mutex_Lock(mutex_t *m, dtime_t timeout)
+{
+    /* get current task id */
+    int task_id = Yield_GetTaskID();
+
+    /* recursive lock */
+    if (m->owner == task_id) {
+        m->depth++; return EOK;
+    }
+    /* mutex is free and nobody waits for it */
+    if (!m->owner && !m->head) {
+        m->owner = task_id, m->depth = 1; return EOK;
+    }
+
+    /* get in line */
+    mutex_waiter_t w = { .task_id = task_id };
+    Mutex_Enqueue(m, &w);
+
+    /* ownership will be given to us by the task that releases the mutex */
+    for (time_t ts = time(0); !w.granted; Yield()) {
+        /* timeout support */
+        if (timeout && dtime_now(ts) > timeout) {
+            Mutex_Remove(m, &w); return ETIMEOUT;
+        }
+    }
+
+    /* we are the owner now */
+    return EOK;
+}
+
+/* try to lock the mutex without waiting */
+err_t Mutex_TryLock(mutex_t *m)
+{
+    /* get current task id */
+    int task_id = Yield_GetTaskID();
+    /* mutex must be free (and with no waiters) or be ours already */
+    if (m->owner != task_id && (m->owner || m->head))
+        return EBUSY;
+
+    /* lock it */
+    return Mutex_Lock(m, 0);
+}
+
+/* release the mutex */
+err_t Mutex_Release(mutex_t *m)
+{
+    /* only the owner may release the mutex */
+    if (m->owner != Yield_GetTaskID())
+        return EARGVAL;
+    /* recursive lock is still being held */
+    if (--m->depth)
+        return EOK;
+
+    /* get the longest waiting task */
+    mutex_waiter_t *w = m->head;
+    /* no one is waiting */
+    if (!w) {
+        m->owner = 0; return EOK;
+    }
+
+    /* dequeue the waiter */
+    if (!(m->head = w->next))
+        m->tail = 0;
+    /* hand over the ownership */
+    m->owner = w->task_id, m->depth = 1;
+    w->granted = 1;
+
+    /* report status */
+    return EOK;
+}
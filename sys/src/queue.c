@@ -35,7 +35,7 @@ queue_t * Queue_Create(size_t size, uint32_t count)
 
     /* initialize queue data structure */
     *q = (queue_t) { .ptr = ptr, .size = size, .count =  count,
-        .head = 0, .tail = 0 };
+        .head = 0, .tail = 0, .hwm = 0 };
 
     /* return the pointer to the queue descriptor */
     return q;
@@ -49,6 +49,16 @@ void Queue_Destroy(queue_t *q)
     Heap_Free(q);
 }
 
+/* keep track of the highest fill level */
+static inline ALWAYS_INLINE void Queue_UpdateHighWatermark(queue_t *q)
+{
+    /* get the current fill level */
+    size_t used = q->head - q->tail;
+    /* new record? */
+    if (used > q->hwm)
+        q->hwm = used;
+}
+
 /* get number of used queue elements */
 size_t Queue_GetUsed(queue_t *q)
 {
@@ -88,30 +98,73 @@ size_t Queue_IncreaseCount(queue_t *q, size_t count)
     size_t max_to_add = min(count, Queue_GetFree(q));
     /* advance the head pointer */
     q->head += max_to_add;
+    Queue_UpdateHighWatermark(q);
     /* return the number of elements dropped */
     return max_to_add;
 }
 
+/* describe the region of 'count' elements starting at counter 'idx' */
+static size_t Queue_GetSpan(queue_t *q, size_t idx, size_t count,
+    queue_span_t *span)
+{
+    /* get the element index within the buffer */
+    size_t buf_idx = idx % q->count;
+    /* check where the wrapping occurs */
+    size_t to_wrap = min(q->count - buf_idx, count);
+
+    /* 1st segment starts at the element, 2nd one at the start of the
+     * buffer */
+    span->seg[0].ptr = q->ptr + buf_idx * q->size;
+    span->seg[0].count = to_wrap;
+    span->seg[1].ptr = q->ptr;
+    span->seg[1].count = count - to_wrap;
+    /* return the total number of elements */
+    return count;
+}
+
+/* reserve free elements for writing in place */
+size_t Queue_Reserve(queue_t *q, size_t count, queue_span_t *span)
+{
+    /* describe as much of the free space as was requested */
+    return Queue_GetSpan(q, q->head, min(count, Queue_GetFree(q)), span);
+}
+
+/* commit the elements written in place */
+size_t Queue_Commit(queue_t *q, size_t count)
+{
+    /* this is the same as increasing the element count */
+    return Queue_IncreaseCount(q, count);
+}
+
+/* get the view of used elements */
+size_t Queue_PeekLinear(queue_t *q, size_t count, queue_span_t *span)
+{
+    /* describe as much of the used space as was requested */
+    return Queue_GetSpan(q, q->tail, min(count, Queue_GetUsed(q)), span);
+}
+
+/* release elements processed in place */
+size_t Queue_Consume(queue_t *q, size_t count)
+{
+    /* this is the same as dropping the elements */
+    return Queue_Drop(q, count);
+}
+
 /* write as much as you can to the queue without waiting for free space */
 size_t Queue_Put(queue_t *q, const void *ptr, size_t count)
 {
     /* byte-wise source data pointer */
-    const uint8_t *p8 = ptr;
-
-    /* limit the number of elements that we can write */
-    size_t to_write = min(count, Queue_GetFree(q));
-    /* get the head element index */
-    size_t head_idx = q->head % q->count;
-    /* check where the wrapping occurs */
-    size_t to_wrap = q->count - head_idx;
-    /* apply limitation */
-    to_wrap = min(to_wrap, to_write);
+    const uint8_t *p8 = ptr; queue_span_t span;
 
+    /* reserve as much as we can write */
+    size_t to_write = Queue_Reserve(q, count, &span);
     /* do the write */
-    memcpy(q->ptr + head_idx * q->size, p8, to_wrap * q->size);
-    memcpy(q->ptr, p8 + to_wrap * q->size, (to_write - to_wrap) * q->size);
+    memcpy(span.seg[0].ptr, p8, span.seg[0].count * q->size);
+    memcpy(span.seg[1].ptr, p8 + span.seg[0].count * q->size,
+        span.seg[1].count * q->size);
     /* commit the change to the queue */
     q->head += to_write;
+    Queue_UpdateHighWatermark(q);
     /* return the actual number of the elements written */
     return to_write;
 }
@@ -146,24 +199,53 @@ size_t Queue_PutWait(queue_t *q, const void *ptr, size_t count, dtime_t timeout)
     return written;
 }
 
+/* write the data into the free space without enqueuing it */
+size_t Queue_PutAt(queue_t *q, size_t offs, const void *ptr, size_t count)
+{
+    /* byte-wise source data pointer */
+    const uint8_t *p8 = ptr; queue_span_t span;
+    /* number of free elements */
+    size_t free = Queue_GetFree(q);
+
+    /* nothing can be written past the free space */
+    if (offs >= free)
+        return 0;
+    /* get the view of the free space that we can write to */
+    size_t to_write = Queue_GetSpan(q, q->head + offs, min(count, free - offs),
+        &span);
+    /* do the write */
+    memcpy(span.seg[0].ptr, p8, span.seg[0].count * q->size);
+    memcpy(span.seg[1].ptr, p8 + span.seg[0].count * q->size,
+        span.seg[1].count * q->size);
+    /* return the actual number of the elements written */
+    return to_write;
+}
+
 /* read the data from the queue but do not advance it's contents */
 size_t Queue_Peek(queue_t *q, void *ptr, size_t count)
 {
-    /* byte-wise destination data pointer */
-    uint8_t *p8 = ptr;
+    /* this is the same as reading from the very tail */
+    return Queue_PeekAt(q, 0, ptr, count);
+}
 
-    /* limit the number of elements that we can read */
-    size_t to_read = min(count, Queue_GetUsed(q));
-    /* get the tail element index */
-    size_t tail_idx = q->tail % q->count;
-    /* check where the wrapping occurs */
-    size_t to_wrap = q->count - tail_idx;
-    /* apply limitation */
-    to_wrap = min(to_wrap, to_read);
+/* read the data from the given offset without dropping it */
+size_t Queue_PeekAt(queue_t *q, size_t offs, void *ptr, size_t count)
+{
+    /* byte-wise destination data pointer */
+    uint8_t *p8 = ptr; queue_span_t span;
+    /* number of used elements */
+    size_t used = Queue_GetUsed(q);
 
+    /* nothing to be read past the head */
+    if (offs >= used)
+        return 0;
+    /* get the view of the data that we can read */
+    size_t to_read = Queue_GetSpan(q, q->tail + offs, min(count, used - offs),
+        &span);
     /* do the reading */
-    memcpy(p8, q->ptr + tail_idx * q->size, to_wrap * q->size);
-    memcpy(p8 + to_wrap * q->size, q->ptr, (to_read - to_wrap) * q->size);
+    memcpy(p8, span.seg[0].ptr, span.seg[0].count * q->size);
+    memcpy(p8 + span.seg[0].count * q->size, span.seg[1].ptr,
+        span.seg[1].count * q->size);
     /* return the actual number of the elements read */
     return to_read;
 }
@@ -207,6 +289,47 @@ size_t Queue_GetWait(queue_t *q, void *ptr, size_t count, dtime_t timeout)
     return read;
 }
 
+/* wait for the fill level to be reached */
+size_t Queue_WaitLevel(queue_t *q, size_t level, dtime_t timeout)
+{
+    /* number of elements stored */
+    size_t used;
+    /* we'll never get more than the queue can hold */
+    level = min(level, (size_t)q->count);
+
+    /* poll on the counters only, this is as cheap as it gets */
+    for (time_t ts = time(0); (used = Queue_GetUsed(q)) < level; Yield())
+        if ((timeout && dtime_now(ts) > timeout) || Yield_IsCancelled())
+            break;
+
+    /* return the number of elements stored */
+    return used;
+}
+
+/* batched read */
+size_t Queue_GetBatchWait(queue_t *q, void *ptr, size_t level, size_t count,
+    dtime_t timeout)
+{
+    /* wait for the batch to form up */
+    Queue_WaitLevel(q, min(level, count), timeout);
+    /* read whatever is there */
+    return Queue_Get(q, ptr, count);
+}
+
+/* get the high-water mark */
+size_t Queue_GetHighWatermark(queue_t *q)
+{
+    /* return the highest fill level */
+    return q->hwm;
+}
+
+/* reset the high-water mark */
+void Queue_ResetHighWatermark(queue_t *q)
+{
+    /* start with what is currently stored */
+    q->hwm = Queue_GetUsed(q);
+}
+
 /* get the pointer to the linear memory */
 void * Queue_GetFreeLinearMem(queue_t *q, size_t *count)
 {
@@ -0,0 +1,156 @@
+/**
+ * @file rwlock.c
+ *
+ * @author Tomasz Watorowski (tomasz.watorowski@gmail.com)
+ * @date 2025-04-12
+ *
+ * @brief Fair reader-writer lock
+ */
+
+#include "err.h"
+#include "sys/rwlock.h"
+#include "sys/time.h"
+#include "sys/yield.h"
+
+/* put the waiter at the end of the queue */
+static void RWLock_Enqueue(rwlock_t *l, rwlock_waiter_t *w)
+{
+    /* append */
+    if (l->tail) {
+        l->tail->next = w;
+    } else {
+        l->head = w;
+    }
+    /* update the tail */
+    l->tail = w;
+}
+
+/* remove the first waiter from the queue */
+static rwlock_waiter_t * RWLock_Dequeue(rwlock_t *l)
+{
+    /* get the first waiter */
+    rwlock_waiter_t *w = l->head;
+    /* unlink it */
+    if (w && !(l->head = w->next))
+        l->tail = 0;
+    /* return it */
+    return w;
+}
+
+/* remove the waiter from the queue */
+static void RWLock_Remove(rwlock_t *l, rwlock_waiter_t *w)
+{
+    /* previous element */
+    rwlock_waiter_t *prev = 0;
+    /* look for the waiter */
+    for (rwlock_waiter_t *p = l->head; p; prev = p, p = p->next) {
+        if (p != w)
+            continue;
+        /* unlink */
+        if (prev) {
+            prev->next = w->next;
+        } else {
+            l->head = w->next;
+        }
+        /* update the tail */
+        if (l->tail == w)
+            l->tail = prev;
+        break;
+    }
+}
+
+/* hand the lock over to the waiters at the head of the queue */
+static void RWLock_Handoff(rwlock_t *l)
+{
+    /* writer still holds the lock */
+    if (l->writer)
+        return;
+
+    /* writer at the head can only proceed when all readers are gone */
+    if (l->head && l->head->write) {
+        if (!l->readers) {
+            rwlock_waiter_t *w = RWLock_Dequeue(l);
+            l->writer = w->task_id; w->granted = 1;
+        }
+        return;
+    }
+
+    /* let in all the readers that are queued before the next writer */
+    while (l->head && !l->head->write) {
+        rwlock_waiter_t *w = RWLock_Dequeue(l);
+        l->readers++; w->granted = 1;
+    }
+}
+
+/* wait in the queue for the lock to be handed over */
+static err_t RWLock_Wait(rwlock_t *l, int write, dtime_t timeout)
+{
+    /* get in line */
+    rwlock_waiter_t w = { .task_id = Yield_GetTaskID(), .write = write };
+    RWLock_Enqueue(l, &w);
+
+    /* lock will be given to us by the releasing task */
+    for (time_t ts = time(0); !w.granted; Yield()) {
+        /* timeout support */
+        if (timeout && dtime_now(ts) > timeout) {
+            /* leave the queue, this may unblock the ones behind us */
+            RWLock_Remove(l, &w); RWLock_Handoff(l);
+            return ETIMEOUT;
+        }
+    }
+
+    /* we've got the lock */
+    return EOK;
+}
+
+/* lock for reading */
+err_t RWLock_LockRead(rwlock_t *l, dtime_t timeout)
+{
+    /* no writer and no one waiting (do not overtake the queued writers) */
+    if (!l->writer && !l->head) {
+        l->readers++; return EOK;
+    }
+
+    /* wait in the queue */
+    return RWLock_Wait(l, 0, timeout);
+}
+
+/* lock for writing */
+err_t RWLock_LockWrite(rwlock_t *l, dtime_t timeout)
+{
+    /* lock is completely free */
+    if (!l->writer && !l->readers && !l->head) {
+        l->writer = Yield_GetTaskID(); return EOK;
+    }
+
+    /* wait in the queue */
+    return RWLock_Wait(l, 1, timeout);
+}
+
+/* release the read lock */
+err_t RWLock_ReleaseRead(rwlock_t *l)
+{
+    /* lock is not held for reading */
+    if (!l->readers)
+        return EARGVAL;
+
+    /* last reader hands the lock over */
+    if (--l->readers == 0)
+        RWLock_Handoff(l);
+    /* report status */
+    return EOK;
+}
+
+/* release the write lock */
+err_t RWLock_ReleaseWrite(rwlock_t *l)
+{
+    /* only the writer may release the lock */
+    if (l->writer != Yield_GetTaskID())
+        return EARGVAL;
+
+    /* release and hand over */
+    l->writer = 0;
+    RWLock_Handoff(l);
+    /* report status */
+    return EOK;
+}
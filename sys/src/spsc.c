@@ -0,0 +1,191 @@
+/**
+ * @file spsc.c
+ *
+ * @author Tomasz Watorowski (tomasz.watorowski@gmail.com)
+ * @date 2025-04-02
+ *
+ * @brief Lock-free single producer, single consumer queue
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "assert.h"
+#include "sys/heap.h"
+#include "sys/spsc.h"
+#include "sys/time.h"
+#include "sys/yield.h"
+#include "util/minmax.h"
+#include "util/string.h"
+
+#ifdef __arm__
+#include "arch/arch.h"
+#endif
+
+/* read the counter that is written by the other side and make sure that
+ * none of the data accesses that follow are done before the read */
+static inline ALWAYS_INLINE uint32_t Spsc_LoadAcquire(volatile uint32_t *cnt)
+{
+#ifdef __arm__
+    /* read the value, then prevent the reordering */
+    uint32_t val = *cnt; Arch_DMB();
+    return val;
+#else
+    return __atomic_load_n(cnt, __ATOMIC_ACQUIRE);
+#endif
+}
+
+/* update our own counter once all the data accesses that preceed it are
+ * complete */
+static inline ALWAYS_INLINE void Spsc_StoreRelease(volatile uint32_t *cnt,
+    uint32_t val)
+{
+#ifdef __arm__
+    /* finish with the data, then publish the counter */
+    Arch_DMB(); *cnt = val;
+#else
+    __atomic_store_n(cnt, val, __ATOMIC_RELEASE);
+#endif
+}
+
+/* initialize the queue over static buffer */
+void Spsc_Init(spsc_t *q, void *ptr, size_t size, uint32_t count)
+{
+    /* counters wrap at 2^32, element indices must follow that */
+    assert(count && !(count & (count - 1)), "spsc count must be a power of 2");
+    /* initialize queue data structure */
+    *q = (spsc_t) { .ptr = ptr, .size = size, .count = count,
+        .head = 0, .tail = 0 };
+}
+
+/* create the queue */
+spsc_t * Spsc_Create(size_t size, uint32_t count)
+{
+    /* queue descriptor */
+    spsc_t *q;
+    /* counters wrap at 2^32, element indices must follow that */
+    if (!count || count & (count - 1))
+        return 0;
+
+    /* allocate the memory for the queue */
+    q = Heap_Malloc(sizeof(spsc_t));
+    /* unable to allocate */
+    if (!q)
+        return 0;
+
+    /* allocate memory for the queue's buffer */
+    void *ptr = Heap_Malloc(size * count);
+    /* unable to allocate? */
+    if (!ptr) {
+        Heap_Free(q); return 0;
+    }
+
+    /* initialize queue data structure */
+    Spsc_Init(q, ptr, size, count);
+    /* return the pointer to the queue descriptor */
+    return q;
+}
+
+/* release the heap memory used by the queue */
+void Spsc_Destroy(spsc_t *q)
+{
+    /* free up the queue's memory */
+    Heap_Free(q->ptr);
+    Heap_Free(q);
+}
+
+/* set the wakeup callback */
+void Spsc_SetPutCallback(spsc_t *q, spsc_cb_t cb, void *arg)
+{
+    /* store both */
+    q->cb_arg = arg; q->cb = cb;
+}
+
+/* get number of used queue elements */
+size_t Spsc_GetUsed(spsc_t *q)
+{
+    /* this is simply equal to the difference in counters */
+    return q->head - q->tail;
+}
+
+/* return the number of free elements in the queue */
+size_t Spsc_GetFree(spsc_t *q)
+{
+    /* subtract the number of used elements form the maximal count */
+    return q->count - Spsc_GetUsed(q);
+}
+
+/* write as much as possible to the queue */
+size_t Spsc_Put(spsc_t *q, const void *ptr, size_t count)
+{
+    /* byte-wise source data pointer */
+    const uint8_t *p8 = ptr;
+    /* head is ours, tail belongs to the consumer */
+    uint32_t head = q->head, tail = Spsc_LoadAcquire(&q->tail);
+
+    /* limit the number of elements that we can write */
+    size_t to_write = min(count, q->count - (head - tail));
+    /* get the head element index */
+    size_t head_idx = head & (q->count - 1);
+    /* check where the wrapping occurs */
+    size_t to_wrap = min(q->count - head_idx, to_write);
+
+    /* do the write */
+    memcpy(q->ptr + head_idx * q->size, p8, to_wrap * q->size);
+    memcpy(q->ptr, p8 + to_wrap * q->size, (to_write - to_wrap) * q->size);
+    /* publish the data to the consumer */
+    Spsc_StoreRelease(&q->head, head + to_write);
+
+    /* notify the consumer */
+    if (to_write && q->cb)
+        q->cb(q->cb_arg);
+    /* return the actual number of the elements written */
+    return to_write;
+}
+
+/* read as much as possible from the queue */
+size_t Spsc_Get(spsc_t *q, void *ptr, size_t count)
+{
+    /* byte-wise destination data pointer */
+    uint8_t *p8 = ptr;
+    /* tail is ours, head belongs to the producer */
+    uint32_t tail = q->tail, head = Spsc_LoadAcquire(&q->head);
+
+    /* limit the number of elements that we can read */
+    size_t to_read = min(count, head - tail);
+    /* get the tail element index */
+    size_t tail_idx = tail & (q->count - 1);
+    /* check where the wrapping occurs */
+    size_t to_wrap = min(q->count - tail_idx, to_read);
+
+    /* do the reading */
+    memcpy(p8, q->ptr + tail_idx * q->size, to_wrap * q->size);
+    memcpy(p8 + to_wrap * q->size, q->ptr, (to_read - to_wrap) * q->size);
+    /* give the memory back to the producer */
+    Spsc_StoreRelease(&q->tail, tail + to_read);
+
+    /* return the actual number of the elements read */
+    return to_read;
+}
+
+/* wait for the data to become available and read it */
+size_t Spsc_GetWait(spsc_t *q, void *ptr, size_t count, dtime_t timeout)
+{
+    /* number of elements read so far */
+    size_t read = 0;
+
+    /* loop as long as more data is to be read from the queue */
+    for (time_t ts = time(0);; Yield()) {
+        /* read what's available */
+        read += Spsc_Get(q, (uint8_t *)ptr + read * q->size, count - read);
+        /* all was read? */
+        if (read == count)
+            break;
+        /* timeout/cancellation support */
+        if ((timeout && dtime_now(ts) > timeout) || Yield_IsCancelled())
+            break;
+    }
+
+    /* return the number of elements read */
+    return read;
+}
@@ -0,0 +1,188 @@
+/**
+ * @file sysconf.c
+ *
+ * @author Tomasz Watorowski (tomasz.watorowski@gmail.com)
+ * @date 2025-04-27
+ *
+ * @brief System configuration
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "assert.h"
+#include "config.h"
+#include "err.h"
+#include "linker.h"
+#include "dev/flash.h"
+#include "dev/usb_eem.h"
+#include "net/tcpip/sock_hash.h"
+#include "net/tcpip/tcp_sock.h"
+#include "net/tcpip/udp_sock.h"
+#include "sys/sysconf.h"
+#include "util/jenkins.h"
+#include "util/string.h"
+
+/* configuration record signature ('SCFG') */
+#define SYSCONF_MAGIC                       0x47464353
+/* estimated size of the heap allocation (alignment + block header) */
+#define SYSCONF_ALLOC_SIZE(size)            ((((size) + 7) & ~7) + 16)
+/* estimated size of the task descriptor and the initial stack frame */
+#define SYSCONF_TASK_SIZE                   256
+
+/* configuration record as stored in flash */
+typedef struct sysconf_rec {
+    /* signature and the size of the configuration */
+    uint32_t magic, size;
+    /* configuration */
+    sysconf_t conf;
+    /* hash computed over all the fields above */
+    uint32_t hash;
+} sysconf_rec_t;
+
+/* configuration in use */
+sysconf_t sysconf;
+
+/* default configuration */
+static const sysconf_t defaults = {
+    .heap_size = SYS_HEAP_SIZE,
+    .coro_stack_size = SYS_CORO_STACK_SIZE,
+    .coro_max_num = SYS_CORO_MAX_NUM,
+    .tcp_sock_num = TCPIP_TCP_SOCK_NUM,
+    .udp_sock_num = TCPIP_UDP_SOCK_NUM,
+    .eem_rx_buf_num = USBEEM_RX_BUF_CAPACITY,
+    .eem_tx_buf_num = USBEEM_TX_BUF_CAPACITY,
+};
+
+/* compute the hash of the record */
+static uint32_t SysConf_Hash(const sysconf_rec_t *rec)
+{
+    /* hash everything but the hash field */
+    return Jenkins_OAAT(SYSCONF_MAGIC, (const uint8_t *)rec,
+        offsetof(sysconf_rec_t, hash));
+}
+
+/* get the start address of the heap memory */
+void * SysConf_GetHeapAddr(void)
+{
+    /* heap starts right after the statically allocated data */
+    return (void *)(((uintptr_t)&__heap_addr + 7) & ~7);
+}
+
+/* get the amount of ram that can be given to the heap */
+size_t SysConf_GetFreeRAM(void)
+{
+    /* heap start address */
+    uintptr_t addr = (uintptr_t)SysConf_GetHeapAddr();
+    /* main stack (used by the interrupts) occupies the top of the ram */
+    uintptr_t end = (uintptr_t)&__stack - SYSCONF_MSP_STACK_SIZE;
+
+    /* no space left at all */
+    return end > addr ? (end - addr) & ~7 : 0;
+}
+
+/* check the configuration against available ram and sane limits */
+err_t SysConf_Validate(const sysconf_t *c)
+{
+    /* heap must fit into the ram that is left */
+    if (c->heap_size & 7 || c->heap_size > SysConf_GetFreeRAM())
+        return EARGVAL;
+    /* we need at least one of each */
+    if (!c->coro_max_num || !c->tcp_sock_num || !c->udp_sock_num ||
+        !c->eem_rx_buf_num || !c->eem_tx_buf_num)
+        return EARGVAL;
+    /* socket lookup tables are sized from the number of sockets */
+    if (c->tcp_sock_num > 0xffff || c->udp_sock_num > 0xffff)
+        return EARGVAL;
+    /* usb buffers are indexed with free running counters */
+    if (c->eem_rx_buf_num & (c->eem_rx_buf_num - 1) ||
+        c->eem_tx_buf_num & (c->eem_tx_buf_num - 1))
+        return EARGVAL;
+    /* stack needs to be aligned and large enough to hold the exception
+     * frame with fpu context */
+    if (c->coro_stack_size & 7 || c->coro_stack_size < 256)
+        return EARGVAL;
+
+    /* memory taken by the pools allocated from the heap */
+    uint64_t pools =
+        /* coroutine table and all coroutine tasks */
+        SYSCONF_ALLOC_SIZE(c->coro_max_num * sizeof(void *)) +
+        (uint64_t)c->coro_max_num * (SYSCONF_ALLOC_SIZE(c->coro_stack_size) +
+            SYSCONF_TASK_SIZE) +
+        /* socket tables */
+        SYSCONF_ALLOC_SIZE((uint64_t)c->tcp_sock_num *
+            sizeof(tcpip_tcp_sock_t)) +
+        SYSCONF_ALLOC_SIZE((uint64_t)c->udp_sock_num *
+            sizeof(tcpip_udp_sock_t)) +
+        /* socket lookup tables (tcp connections and listeners, udp) */
+        SYSCONF_ALLOC_SIZE(2 * TCPIPSockHash_GetSize(c->tcp_sock_num) *
+            sizeof(void *)) +
+        SYSCONF_ALLOC_SIZE(TCPIPSockHash_GetSize(c->udp_sock_num) *
+            sizeof(void *)) +
+        /* usb ethernet frame buffers (frame with the eem header and
+         * checksum + size and reference count) and the queues of frames */
+        SYSCONF_ALLOC_SIZE((uint64_t)c->eem_rx_buf_num *
+            (USBEEM_BUF_SIZE + 2 * sizeof(size_t))) +
+        SYSCONF_ALLOC_SIZE((uint64_t)c->eem_rx_buf_num * 2 * sizeof(uint32_t)) +
+        SYSCONF_ALLOC_SIZE((uint64_t)c->eem_tx_buf_num *
+            (USBEEM_BUF_SIZE + 2 * sizeof(size_t))) +
+        SYSCONF_ALLOC_SIZE((uint64_t)c->eem_tx_buf_num * sizeof(uint32_t));
+
+    /* leave enough space for the tasks and socket queues */
+    if (pools + SYSCONF_HEAP_RESERVE > c->heap_size)
+        return EARGVAL;
+
+    /* all is ok */
+    return EOK;
+}
+
+/* load the configuration */
+err_t SysConf_Init(void)
+{
+    /* record stored at the beginning of the storage area */
+    const sysconf_rec_t *rec = (const sysconf_rec_t *)&__flash_strg_addr;
+
+    /* defaults from config.h must fit into the ram that the linker left,
+     * otherwise the heap would overlap the main stack */
+    assert(SysConf_Validate(&defaults) == EOK,
+        "default system configuration does not fit");
+
+    /* check the record, configurations of different size come from other
+     * firmware versions and are not trusted */
+    if (rec->magic == SYSCONF_MAGIC && rec->size == sizeof(sysconf_t) &&
+        rec->hash == SysConf_Hash(rec) && SysConf_Validate(&rec->conf) == EOK) {
+        sysconf = rec->conf;
+        return EOK;
+    }
+
+    /* fall back to the defaults */
+    sysconf = defaults;
+    /* report that the defaults are used */
+    return EFATAL;
+}
+
+/* persist the configuration */
+err_t SysConf_Store(const sysconf_t *conf)
+{
+    /* error code */
+    err_t ec;
+    /* record to be stored */
+    sysconf_rec_t rec = { .magic = SYSCONF_MAGIC, .size = sizeof(sysconf_t) };
+
+    /* do not store anything that will not boot */
+    if ((ec = SysConf_Validate(conf)) != EOK)
+        return ec;
+
+    /* prepare the record */
+    rec.conf = *conf; rec.hash = SysConf_Hash(&rec);
+
+    /* erase the storage and program the record */
+    if ((ec = Flash_EraseSectorsForAddressRange(&__flash_strg_addr,
+        sizeof(rec))) < EOK)
+        return ec;
+    if ((ec = Flash_Write(&__flash_strg_addr, &rec, sizeof(rec))) < EOK)
+        return ec;
+
+    /* make sure that it was stored correctly */
+    return Flash_Verify(&__flash_strg_addr, &rec, sizeof(rec));
+}
@@ -11,88 +11,139 @@
 #include "err.h"
 
 #include "arch/arch.h"
+#include "dev/cpuclock.h"
 #include "stm32f401/scb.h"
 #include "stm32f401/systick.h"
+#include "sys/time.h"
 
 
-/* reload register value */
-#define RELOAD                              ((AHBCLOCK_HZ / 8) - 1)
-/* number of systick overflows, should be incremented by 1000 per overflow */
-static volatile uint32_t ticks;
+/* reload register value for given ahb frequency */
+#define RELOAD(ahb_hz)                      (((ahb_hz) / 8) - 1)
+/* current reload register value */
+static uint32_t reload;
+/* number of systick overflows (seconds) */
+static volatile uint32_t secs;
+/* multipliers for converting the systick count to us and ms */
+static uint32_t mult_us, mult_ms;
 
 /* systick overflow exception handler */
 void Time_TickHander(void)
 {
-    /* bump up the ticks counter */
-    ticks += 1000;
+    /* bump up the seconds counter */
+    secs++;
 }
 
+/* clock change callback */
+static void Time_ClockChanged(void);
+
 /* intialize system timer circuitry */
 err_t Time_Init(void)
 {
     /* set the context switcher priority to the lowest possible level */
     SCB_SETEXCPRI(STM32_EXC_SYSTICK, INT_PRI_SYSTICK);
 
+    /* reload value for the clock that we are running at */
+    reload = RELOAD(CpuClock_GetAHBHz());
     /* sanity checks */
-    assert(RELOAD > 1e6, 
+    assert(reload > 1e6, 
         "reload value is low, consider speeding up the systick");
-    assert(RELOAD <= SYSTICK_LOAD_RELOAD, 
+    assert(RELOAD(AHBCLOCK_HZ) <= SYSTICK_LOAD_RELOAD, 
         "reload value too high - slow down the systick timer");
 
+    /* compute the conversion factors once, so that no division is needed
+     * when reading the time */
+    mult_us = Time_ReciprocalMult(1000000, reload + 1);
+    mult_ms = Time_ReciprocalMult(1000, reload + 1);
+
     /* setup the reload value */
-    SYSTICK->LOAD = RELOAD;
+    SYSTICK->LOAD = reload;
     /* start the timer and enable interrupt generation */
     SYSTICK->CTRL |= SYSTICK_CTRL_ENABLE | SYSTICK_CTRL_TICKINT;
+    /* follow the clock changes */
+    CpuClock_RegisterCallback(Time_ClockChanged);
 
     /* initialize  */
     return EOK;
 }
 
+/* get the consistent pair of the seconds counter and the systick count */
+static inline ALWAYS_INLINE uint32_t Time_Read(uint32_t *count)
+{
+    /* seconds counter as seen before and after reading the count */
+    uint32_t s, s_prev;
+
+    /* retry if the overflow interrupt got served in the meantime */
+    do {
+        /* read both counters */
+        s = s_prev = secs; *count = reload - SYSTICK->VAL;
+        /* systick wrapped around but the interrupt was not served yet (we
+         * are within the critical section or it is just about to be taken) */
+        if ((SCB->ICSR & SCB_ICSR_PENDSTSET) && *count < reload / 2)
+            s++;
+    } while (s_prev != secs);
+
+    /* return the number of seconds */
+    return s;
+}
+
+/* clock has changed, called with interrupts disabled */
+static void Time_ClockChanged(void)
+{
+    /* current time as seen with the old settings */
+    uint32_t count, s = Time_Read(&count);
+    /* reload value for the new clock */
+    uint32_t new_reload = RELOAD(CpuClock_GetAHBHz());
+    /* part of the second that has already elapsed expressed in new ticks */
+    uint32_t offs = (uint64_t)count * (new_reload + 1) / (reload + 1);
+    /* keep at least one tick in the current period */
+    if (offs >= new_reload)
+        offs = new_reload - 1;
+
+    /* new conversion factors */
+    reload = new_reload;
+    mult_us = Time_ReciprocalMult(1000000, reload + 1);
+    mult_ms = Time_ReciprocalMult(1000, reload + 1);
+
+    /* the counter cannot be written with an arbitrary value, so the current
+     * period is shortened by the part that has already elapsed */
+    SYSTICK->LOAD = reload - offs; SYSTICK->VAL = 0;
+    /* wait for the counter to pick up the shortened period */
+    while (SYSTICK->VAL == 0);
+    /* following periods are full seconds */
+    SYSTICK->LOAD = reload;
+
+    /* wrap-around that was not served yet was accounted by Time_Read() */
+    SCB->ICSR = SCB_ICSR_PENDSTCLR; secs = s;
+}
+
 /* return the time in ms */
 uint32_t OPTIMIZE("O3") Time_GetTime(void)
 {
-    uint32_t ms;
-    /* loop as long as we do not have a stable read from 'ticks' and 
-     * systick->val */
-    while (1) {
-        /* this allows to check whether interrupt has occured between the 
-         * calls of ldrex and strex */
-        Arch_LDREX(&ms);
-        /* ensure that we read the fresh value of 'ticks' */
-        Arch_DSB();
-        /* if this equals 0 then no intterupt has occured  since ldrex */
-        if (Arch_STREX(&ms, ticks + (RELOAD - SYSTICK->VAL) / (RELOAD / 1000)) == 0) {
-            Arch_DSB();
-            return ms;
-        }
-    }
+    /* systick count */
+    uint32_t count, s = Time_Read(&count);
+    /* convert to ms */
+    return s * 1000 + Time_Scale(count, mult_ms);
+}
+
+/* return the time in us */
+time_us_t OPTIMIZE("O3") Time_GetTimeUS(void)
+{
+    /* systick count */
+    uint32_t count, s = Time_Read(&count);
+    /* convert to us */
+    return (time_us_t)s * 1000000 + Time_Scale(count, mult_us);
 }
 
 /* get micoseconds value */
 uint32_t OPTIMIZE("O3") Time_GetUS(void)
 {
-    /* get the value and leave the "microseconds" part */
-    uint32_t us = (RELOAD - SYSTICK->VAL) % (RELOAD / 100);
-    /* scale to microseconds */
-    return us * 10000 / (RELOAD / 100);
+    /* leave the "microseconds" part of the current second */
+    return Time_Scale(reload - SYSTICK->VAL, mult_us) % 10000;
 }
 
 /* simple delay function */
 void OPTIMIZE("O3") Time_DelayUS(uint32_t us)
 {
-    /* microsecond timestamps */
-    uint32_t curr_us, prev_us = Time_GetUS();
-
     /* loop until timing is met */
-    for (uint32_t elapsed = 0; elapsed < us; ) {
-        /* get current timestamp */
-        curr_us = Time_GetUS();
-        /* get the difference between timestamps */
-        uint32_t diff = curr_us - prev_us;
-        /* us counter overflow? */
-        if (diff > 10000)
-            diff = 10000 + diff;
-        /* update the elapsed counter */
-        elapsed += diff; prev_us = curr_us;
-    }
-}
\ No newline at end of file
+    for (time_us_t ts = Time_GetTimeUS(); Time_GetTimeUS() - ts < us; );
+}
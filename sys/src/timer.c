@@ -0,0 +1,174 @@
+/**
+ * @file timer.c
+ *
+ * @author Tomasz Watorowski (tomasz.watorowski@gmail.com)
+ * @date 2025-04-16
+ *
+ * @brief Software timers
+ */
+
+#include "config.h"
+#include "err.h"
+#include "sys/time.h"
+#include "sys/timer.h"
+#include "sys/yield.h"
+
+/* min-heap of running timers ordered by the expiration time */
+static systimer_t *heap[SYS_TIMER_MAX_NUM];
+/* number of elements in the heap */
+static int heap_size;
+
+/* does timer 'a' expire before 'b'? */
+static inline int Timer_Before(systimer_t *a, systimer_t *b)
+{
+    return dtime(a->expires, b->expires) < 0;
+}
+
+/* place the timer at given heap position */
+static inline void Timer_Place(systimer_t *t, int pos)
+{
+    heap[pos] = t; t->pos = pos + 1;
+}
+
+/* move the element up the heap until the heap property is restored */
+static void Timer_SiftUp(int pos)
+{
+    /* element being moved */
+    systimer_t *t = heap[pos];
+
+    /* go up as long as the parent expires later */
+    for (int parent; pos > 0; pos = parent) {
+        parent = (pos - 1) / 2;
+        if (!Timer_Before(t, heap[parent]))
+            break;
+        Timer_Place(heap[parent], pos);
+    }
+    /* store at final position */
+    Timer_Place(t, pos);
+}
+
+/* move the element down the heap until the heap property is restored */
+static void Timer_SiftDown(int pos)
+{
+    /* element being moved */
+    systimer_t *t = heap[pos];
+
+    /* go down as long as any of the children expires earlier */
+    for (int child; (child = 2 * pos + 1) < heap_size; pos = child) {
+        /* pick the child that expires earlier */
+        if (child + 1 < heap_size && Timer_Before(heap[child + 1], heap[child]))
+            child++;
+        if (!Timer_Before(heap[child], t))
+            break;
+        Timer_Place(heap[child], pos);
+    }
+    /* store at final position */
+    Timer_Place(t, pos);
+}
+
+/* put the timer onto the heap */
+static err_t Timer_Insert(systimer_t *t)
+{
+    /* no more space */
+    if (heap_size == SYS_TIMER_MAX_NUM)
+        return EBUSY;
+    /* append and restore the ordering */
+    Timer_Place(t, heap_size++); Timer_SiftUp(heap_size - 1);
+    /* report status */
+    return EOK;
+}
+
+/* remove the timer from the heap */
+static void Timer_Remove(systimer_t *t)
+{
+    /* timer position */
+    int pos = t->pos - 1;
+    /* take the last element */
+    systimer_t *last = heap[--heap_size];
+
+    /* mark as stopped */
+    t->pos = 0;
+    /* removed element was the last one */
+    if (last == t)
+        return;
+    /* put the last element in place of the removed one and restore the
+     * ordering in whichever direction is needed */
+    Timer_Place(last, pos);
+    if (pos > 0 && Timer_Before(last, heap[(pos - 1) / 2])) {
+        Timer_SiftUp(pos);
+    } else {
+        Timer_SiftDown(pos);
+    }
+}
+
+/* timer task */
+static void Timer_Task(void *arg)
+{
+    /* call the callbacks as the timers expire */
+    for (;; Yield())
+        Timer_Poll();
+}
+
+/* initialize the timer service */
+err_t Timer_Init(void)
+{
+    /* start the task */
+    if (Yield_Task(Timer_Task, 0, SYS_TIMER_STACK_SIZE) < EOK)
+        return EFATAL;
+    /* report status */
+    return EOK;
+}
+
+/* start the timer */
+err_t Timer_Start(systimer_t *t, timer_cb_t cb, void *arg, dtime_t delay,
+    dtime_t period)
+{
+    /* restarting the timer */
+    if (Timer_IsRunning(t))
+        Timer_Remove(t);
+
+    /* setup the timer */
+    t->cb = cb, t->arg = arg, t->period = period;
+    t->expires = time(0) + delay;
+
+    /* put on the heap */
+    return Timer_Insert(t);
+}
+
+/* stop the timer */
+err_t Timer_Stop(systimer_t *t)
+{
+    /* remove from the heap */
+    if (Timer_IsRunning(t))
+        Timer_Remove(t);
+    /* report status */
+    return EOK;
+}
+
+/* process the expired timers */
+dtime_t Timer_Poll(void)
+{
+    /* current time */
+    time_t now = time(0);
+
+    /* serve all the timers that have expired */
+    while (heap_size && dtime(now, heap[0]->expires) >= 0) {
+        /* timer that expired */
+        systimer_t *t = heap[0];
+        /* take it off the heap before calling the callback, so that it is
+         * free to restart or stop the timer */
+        Timer_Remove(t);
+        /* periodic timer: keep the phase unless we are way behind */
+        if (t->period) {
+            t->expires += t->period;
+            if (dtime(now, t->expires) >= 0)
+                t->expires = now + t->period;
+            Timer_Insert(t);
+        }
+        /* call the callback */
+        t->cb(t->arg);
+    }
+
+    /* report the time to the next expiration */
+    return heap_size ? dtime(heap[0]->expires, now) : -1;
+}
@@ -17,13 +17,17 @@
 #include "linker.h"
 #include "arch/arch.h"
 #include "dev/watchdog.h"
+#include "stm32f401/dwt.h"
 #include "stm32f401/stm32f401.h"
 #include "stm32f401/nvic.h"
 #include "stm32f401/scb.h"
+#include "sys/critical.h"
 #include "sys/heap.h"
+#include "sys/sysconf.h"
 #include "sys/time.h"
 #include "sys/yield.h"
 #include "util/elems.h"
+#include "util/string.h"
 
 /* tasks stack frame - backwards since it it placed on stack, in basic mode: 
  * a.k.a no floating point registers */
@@ -101,11 +105,15 @@ typedef struct task {
 static task_t *curr_task;
 /* context switch counter */
 static volatile uint32_t switch_cnt, task_cnt;
+/* cycle counter value at the beginning of current time slice */
+static uint32_t slice_start;
+/* cycles spent in busy slices and in all slices */
+static volatile uint32_t load_busy, load_total;
 /* task id to be assigned to the next task that is created */
 static int next_task_id = 1;
 
-/* tasks that wrap coroutines */
-static task_t *coroutines[SYS_CORO_MAX_NUM];
+/* tasks that wrap coroutines (table is sized at boot, see sysconf.h) */
+static task_t **coroutines; static size_t coroutines_num;
  
 
 /* initiate context switch procedure */
@@ -239,7 +247,7 @@ static void Yield_InitializeTask(task_t *t, void (*handler)(void *), void *arg,
 }
 
 /* validate that tasks' stack was not corrupted */
-static void Yield_CheckStack(void)
+static void HOT Yield_CheckStack(void)
 {
     /* these checks are valid only for tasks that have their own stack: i.e. 
      * subtasks of the main task */
@@ -252,11 +260,18 @@ static void Yield_CheckStack(void)
 }
 
 /* select next task to be executed */
-static void Yield_Schedule(void)
+static void HOT Yield_Schedule(void)
 {
     /* bump up the counter */
     switch_cnt++;
 
+    /* length of the time slice that has just ended */
+    uint32_t now = DWT->CYCCNT, slice = now - slice_start;
+    /* account the slice, long ones mean that the task was doing the work */
+    load_total += slice, slice_start = now;
+    if (slice > SYS_YIELD_BUSY_SLICE_CYCLES)
+        load_busy += slice;
+
     /* loop until next task is found */
     while (1) {
         /* task is completed? */
@@ -302,7 +317,7 @@ static task_t * Yield_GetTaskByID(int task_id)
 }
 
 /* context switch interrupt */
-void NAKED OPTIMIZE ("Os") Yield_PendSVHandler(void)
+void NAKED HOT OPTIMIZE ("Os") Yield_PendSVHandler(void)
 {
     /* stack pointer holding register */
     register task_frame_t *sp;
@@ -375,6 +390,17 @@ err_t Yield_Init(void)
 {
     /* set the context switcher priority to the lowest possible level */
     SCB_SETEXCPRI(STM32_EXC_PENDSV, INT_PRI_YIELD);
+    /* enable the cycle counter used for the load accounting */
+    DCB->DEMCR |= DCB_DEMCR_TRCENA;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA;
+
+    /* allocate the coroutine table */
+    coroutines_num = sysconf.coro_max_num;
+    coroutines = Heap_Malloc(coroutines_num * sizeof(*coroutines));
+    /* sanity check */
+    assert(coroutines, "unable to allocate coroutine table");
+    /* all slots are free */
+    memset(coroutines, 0, coroutines_num * sizeof(*coroutines));
 
     /* return status */
     return EOK;
@@ -431,7 +457,7 @@ err_t Yield_Run(void (*handler)(void *), void *arg)
     for (; !found; Yield()) {
         /* go through all coroutine control blocks and find one that can be 
          * used for starting the coroutine  */
-        for (coro = coroutines; coro != coroutines + elems(coroutines); coro++) {
+        for (coro = coroutines; coro != coroutines + coroutines_num; coro++) {
             /* this means either free slot or a slot occupied by the task that 
              * is already completed */
             if (!(*coro) || (*coro)->state == TASK_DONE) {
@@ -443,7 +469,7 @@ err_t Yield_Run(void (*handler)(void *), void *arg)
     }
 
     /* empty slot, we need to allocate memory */
-    if (!*coro && !(*coro = Yield_AllocateTask(SYS_CORO_STACK_SIZE)))
+    if (!*coro && !(*coro = Yield_AllocateTask(sysconf.coro_stack_size)))
         return EFATAL;
 
     /* prepare the task for execution */
@@ -561,4 +587,17 @@ int Yield_IsCancelled(void)
 {
     /* return the state of is cancelled flag */
     return !curr_task->shielded && curr_task->cancelled;
-}
\ No newline at end of file
+}
+
+/* read and reset the load counters */
+void Yield_ReadLoad(uint32_t *busy, uint32_t *total)
+{
+    /* counters are updated from the context switcher */
+    Critical_Enter();
+    /* read */
+    *busy = load_busy, *total = load_total;
+    /* reset */
+    load_busy = load_total = 0;
+    /* end of critical section */
+    Critical_Exit();
+}
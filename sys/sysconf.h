@@ -0,0 +1,81 @@
+/**
+ * @file sysconf.h
+ *
+ * @author Tomasz Watorowski (tomasz.watorowski@gmail.com)
+ * @date 2025-04-27
+ *
+ * @brief System configuration: sizes of the memory pools (heap, coroutines,
+ * sockets, usb buffers) that are decided upon at boot. Configuration is read
+ * from the block persisted in flash storage, validated against the available
+ * ram and replaced with the defaults from config.h when invalid. Defaults
+ * are validated as well, boot stops (assert) when they do not fit.
+ */
+
+#ifndef SYS_SYSCONF_H
+#define SYS_SYSCONF_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "err.h"
+
+/** system configuration */
+typedef struct sysconf {
+    /* size of the heap */
+    uint32_t heap_size;
+    /* coroutine stack size, maximal number of concurrent coroutines */
+    uint32_t coro_stack_size, coro_max_num;
+    /* number of tcp and udp sockets */
+    uint32_t tcp_sock_num, udp_sock_num;
+    /* number of usb ethernet frame buffers for reception and transmission */
+    uint32_t eem_rx_buf_num, eem_tx_buf_num;
+} sysconf_t;
+
+/** configuration in use (valid after SysConf_Init()) */
+extern sysconf_t sysconf;
+
+/**
+ * @brief load the configuration from the flash storage or fall back to the
+ * defaults if there is no valid configuration stored. Called before the heap
+ * is initialized.
+ *
+ * @return err_t EOK if stored configuration was loaded, EFATAL when defaults
+ * are used
+ */
+err_t SysConf_Init(void);
+
+/**
+ * @brief get the start address of the heap memory
+ *
+ * @return void * heap memory address
+ */
+void * SysConf_GetHeapAddr(void);
+
+/**
+ * @brief get the amount of ram that can be given to the heap
+ *
+ * @return size_t size in bytes
+ */
+size_t SysConf_GetFreeRAM(void);
+
+/**
+ * @brief check the configuration against available ram and sane limits
+ *
+ * @param conf configuration to be checked
+ *
+ * @return err_t EOK if configuration is usable, EARGVAL otherwise
+ */
+err_t SysConf_Validate(const sysconf_t *conf);
+
+/**
+ * @brief persist the configuration in flash storage. Takes effect after the
+ * reset. Must be called from within a task as the flash erase takes time.
+ * Exposed through the '/sysconf' endpoint of the api server (see api.h).
+ *
+ * @param conf configuration to be stored
+ *
+ * @return err_t error code
+ */
+err_t SysConf_Store(const sysconf_t *conf);
+
+#endif /* SYS_SYSCONF_H */
@@ -19,6 +19,8 @@
 typedef uint32_t time_t;
 /* default time difference type */
 typedef int32_t dtime_t;
+/* monotonic microsecond timestamp type (does not wrap in practice) */
+typedef uint64_t time_us_t;
 
 
 /** @brief systick overflow exception handler */
@@ -38,6 +40,13 @@ err_t Time_Init(void);
  */
 uint32_t Time_GetTime(void);
 
+/**
+ * @brief return the absolute time in us. 64-bit wide so it does not wrap
+ *
+ * @return time_us_t timestamp in us
+ */
+time_us_t Time_GetTimeUS(void);
+
 /**
  * @brief return microseconds counter value in range of 0-9999us
  *
@@ -54,6 +63,37 @@ uint32_t Time_GetUS(void);
  */
 void Time_DelayUS(uint32_t us);
 
+/**
+ * @brief Compute the multiplier that converts timer counts of given frequency
+ * to given units (e.g. 1000 for ms) without division: see Time_Scale()
+ *
+ * @param units number of units per second
+ * @param freq timer counting frequency in Hz (must be greater than units)
+ *
+ * @return uint32_t multiplier
+ */
+static inline ALWAYS_INLINE uint32_t Time_ReciprocalMult(uint32_t units,
+    uint32_t freq)
+{
+    return ((uint64_t)units << 32) / freq;
+}
+
+/**
+ * @brief Convert the timer count to units using the multiplier computed by
+ * Time_ReciprocalMult(). Compiles to a single long multiply. Result may
+ * be one unit behind the exact value, but is monotonic in count and never
+ * reaches the full second.
+ *
+ * @param count timer count
+ * @param mult multiplier
+ *
+ * @return uint32_t number of units
+ */
+static inline ALWAYS_INLINE uint32_t Time_Scale(uint32_t count, uint32_t mult)
+{
+    return ((uint64_t)count * mult) >> 32;
+}
+
 /**
  * @brief Get current system time timer value in ms;
  *
@@ -72,6 +112,24 @@ static inline ALWAYS_INLINE time_t time(time_t *t)
     return ms;
 }
 
+/**
+ * @brief Get current system time in us
+ *
+ * @param t place to store the timestamp to (may be null)
+ *
+ * @return system time value in us
+ */
+static inline ALWAYS_INLINE time_us_t time_us(time_us_t *t)
+{
+    /* get current system timer value */
+    time_us_t us = Time_GetTimeUS();
+    /* store within the pointer value */
+    if (t)
+        *t = us;
+    /* return the value */
+    return us;
+}
+
 /**
  * @brief Get the time difference between two timestamps: a - b
  *
@@ -0,0 +1,83 @@
+/**
+ * @file timer.h
+ *
+ * @author Tomasz Watorowski (tomasz.watorowski@gmail.com)
+ * @date 2025-04-16
+ *
+ * @brief Software timers: callbacks called after given delay (and optionally
+ * periodically) from within a single timer task. Pending timers are kept in
+ * the binary min-heap ordered by the expiration time.
+ */
+
+#ifndef SYS_TIMER_H
+#define SYS_TIMER_H
+
+#include "err.h"
+#include "sys/time.h"
+
+/** timer callback */
+typedef void (* timer_cb_t)(void *arg);
+
+/** timer descriptor, storage is provided by the user */
+typedef struct systimer {
+    /* callback and its argument */
+    timer_cb_t cb; void *arg;
+    /* expiration timestamp */
+    time_t expires;
+    /* period (0 for single shot timers) */
+    dtime_t period;
+    /* position within the heap + 1 (0 - timer is not running) */
+    int pos;
+} systimer_t;
+
+/**
+ * @brief initialize the timer service and start the timer task
+ *
+ * @return err_t error code
+ */
+err_t Timer_Init(void);
+
+/**
+ * @brief start the timer (or restart if it is already running). Callback is
+ * called from within the timer task, so it shall not block for long. It is
+ * allowed to start and stop timers (including its own) from the callback.
+ *
+ * @param t timer descriptor (must remain valid as long as timer is running)
+ * @param cb callback
+ * @param arg callback argument
+ * @param delay delay in ms after which the callback is called for the 1st time
+ * @param period callback period in ms (0 - call only once)
+ *
+ * @return err_t EOK or EBUSY if there are too many running timers
+ */
+err_t Timer_Start(systimer_t *t, timer_cb_t cb, void *arg, dtime_t delay,
+    dtime_t period);
+
+/**
+ * @brief stop the timer. Does nothing if timer is not running.
+ *
+ * @param t timer descriptor
+ *
+ * @return err_t error code
+ */
+err_t Timer_Stop(systimer_t *t);
+
+/**
+ * @brief is the timer still running?
+ *
+ * @param t timer descriptor
+ *
+ * @return int 1 if running, 0 otherwise
+ */
+static inline int Timer_IsRunning(systimer_t *t) { return t->pos != 0; }
+
+/**
+ * @brief call the callbacks of all the timers that have expired. Called in a
+ * loop by the timer task, exposed for testing.
+ *
+ * @return dtime_t time to the next expiration in ms (or -1 if no timers are
+ * running)
+ */
+dtime_t Timer_Poll(void);
+
+#endif /* SYS_TIMER_H */
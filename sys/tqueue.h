@@ -0,0 +1,106 @@
+/**
+ * @file tqueue.h
+ *
+ * @author Tomasz Watorowski (tomasz.watorowski@gmail.com)
+ * @date 2025-04-05
+ *
+ * @brief Typed queues with compile-time capacity. Element size is constant and
+ * the capacity is a power of two so wrapping is done with masking instead of
+ * the division. For queues with runtime parameters use queue.h.
+ *
+ * QUEUE_DECLARE(rxq, uint16_t, 64) produces static storage named 'rxq' and a
+ * set of inline functions: rxq_GetUsed(), rxq_GetFree(), rxq_Put(),
+ * rxq_Get(), rxq_Peek(), rxq_Drop(), rxq_PutOne() and rxq_GetOne().
+ */
+
+#ifndef SYS_TQUEUE_H
+#define SYS_TQUEUE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "compiler.h"
+#include "util/string.h"
+
+/** declare typed queue 'name' holding 'capacity' elements of type 'type' */
+#define QUEUE_DECLARE(name, type, capacity)                                     \
+    _Static_assert((capacity) > 0 && ((capacity) & ((capacity) - 1)) == 0,      \
+        "queue capacity must be a power of two");                               \
+                                                                                \
+    /* queue storage along with the counters */                                 \
+    static struct {                                                             \
+        /* element buffer */                                                    \
+        type buf[capacity];                                                     \
+        /* head and tail counters */                                            \
+        uint32_t head, tail;                                                    \
+    } name;                                                                     \
+                                                                                \
+    /* number of elements stored */                                             \
+    static inline ALWAYS_INLINE UNUSED size_t name##_GetUsed(void)              \
+    {                                                                           \
+        return name.head - name.tail;                                           \
+    }                                                                           \
+                                                                                \
+    /* number of free elements */                                               \
+    static inline ALWAYS_INLINE UNUSED size_t name##_GetFree(void)              \
+    {                                                                           \
+        return (capacity) - name##_GetUsed();                                   \
+    }                                                                           \
+                                                                                \
+    /* write as many elements as possible */                                    \
+    static inline UNUSED size_t name##_Put(const type *ptr, size_t count)       \
+    {                                                                           \
+        /* limit to what fits, see where the buffer wraps */                    \
+        size_t n = count < name##_GetFree() ? count : name##_GetFree();         \
+        size_t idx = name.head & ((capacity) - 1);                              \
+        size_t wrap = n < (capacity) - idx ? n : (capacity) - idx;              \
+        /* store the data */                                                    \
+        memcpy(name.buf + idx, ptr, wrap * sizeof(type));                       \
+        memcpy(name.buf, ptr + wrap, (n - wrap) * sizeof(type));                \
+        /* commit */                                                            \
+        name.head += n; return n;                                               \
+    }                                                                           \
+                                                                                \
+    /* read elements without dropping them */                                   \
+    static inline UNUSED size_t name##_Peek(type *ptr, size_t count)            \
+    {                                                                           \
+        /* limit to what is stored, see where the buffer wraps */               \
+        size_t n = count < name##_GetUsed() ? count : name##_GetUsed();         \
+        size_t idx = name.tail & ((capacity) - 1);                              \
+        size_t wrap = n < (capacity) - idx ? n : (capacity) - idx;              \
+        /* fetch the data */                                                    \
+        memcpy(ptr, name.buf + idx, wrap * sizeof(type));                       \
+        memcpy(ptr + wrap, name.buf, (n - wrap) * sizeof(type));                \
+        return n;                                                               \
+    }                                                                           \
+                                                                                \
+    /* drop elements */                                                         \
+    static inline ALWAYS_INLINE UNUSED size_t name##_Drop(size_t count)         \
+    {                                                                           \
+        size_t n = count < name##_GetUsed() ? count : name##_GetUsed();         \
+        name.tail += n; return n;                                               \
+    }                                                                           \
+                                                                                \
+    /* read elements and drop them */                                           \
+    static inline UNUSED size_t name##_Get(type *ptr, size_t count)             \
+    {                                                                           \
+        return name##_Drop(name##_Peek(ptr, count));                            \
+    }                                                                           \
+                                                                                \
+    /* write single element, returns 1 on success, 0 if queue is full */        \
+    static inline ALWAYS_INLINE UNUSED int name##_PutOne(type value)            \
+    {                                                                           \
+        if (name##_GetUsed() == (capacity))                                     \
+            return 0;                                                           \
+        name.buf[name.head++ & ((capacity) - 1)] = value; return 1;             \
+    }                                                                           \
+                                                                                \
+    /* read single element, returns 1 on success, 0 if queue is empty */        \
+    static inline ALWAYS_INLINE UNUSED int name##_GetOne(type *value)           \
+    {                                                                           \
+        if (name.head == name.tail)                                             \
+            return 0;                                                           \
+        *value = name.buf[name.tail++ & ((capacity) - 1)]; return 1;            \
+    }
+
+#endif /* SYS_TQUEUE_H */
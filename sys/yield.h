@@ -11,6 +11,7 @@
 #define SYS_YIELD
 
 #include <stddef.h>
+#include <stdint.h>
 
 #include "err.h"
 #include "sys/time.h"
@@ -144,5 +145,16 @@ void Yield_CancelAll(int task_ids[]);
  */
 int Yield_IsCancelled(void);
 
+/**
+ * @brief read and reset the scheduler load counters. Every time slice (time
+ * between the task being switched in and yielding) is accounted in cpu
+ * cycles. Slices longer than SYS_YIELD_BUSY_SLICE_CYCLES are considered busy,
+ * shorter ones are just the tasks polling for their conditions.
+ *
+ * @param busy number of cycles spent in busy slices
+ * @param total number of cycles spent in all slices
+ */
+void Yield_ReadLoad(uint32_t *busy, uint32_t *total);
+
 
 #endif /* SYS_YIELD */
@@ -0,0 +1,92 @@
+/**
+ * @file bench.h
+ * @author Tomasz Watorowski (tomasz.watorowski@gmail.com)
+ * @date 2025-04-20
+ *
+ * @brief Microbenchmark harness. Benchmarks are registered with the BENCH()
+ * macro anywhere in the code, each one is warmed up and then every iteration
+ * is measured separately so that min and median can be reported. On target
+ * the DWT cycle counter is used, on the host (linux) the monotonic clock in ns.
+ *
+ * BENCH(memcpy_1k, 1024) {
+ *     memcpy(dst, src, 1024); BENCH_KEEP(dst);
+ * }
+ */
+
+#ifndef TEST_BENCH_H
+#define TEST_BENCH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "compiler.h"
+#include "config.h"
+#include "err.h"
+
+/** benchmark descriptor */
+typedef struct bench {
+    /* name of the benchmark */
+    const char *name;
+    /* single iteration */
+    void (*func)(void);
+    /* number of bytes processed in single iteration (0 if not applicable) */
+    size_t bytes;
+} bench_t;
+
+/** benchmark results */
+typedef struct bench_result {
+    /* shortest and median iteration time in counter units */
+    uint32_t min, median;
+} bench_result_t;
+
+/** output function for the results */
+typedef void (* bench_out_t)(const char *str, size_t len);
+
+/** register a benchmark: the descriptor goes into the 'bench' section which
+ * is walked by Bench_RunAll(). Nothing is registered (and the benchmark body
+ * is discarded) unless the benchmarks are enabled (make BENCH=1) */
+#if BENCH_ENABLED
+#define BENCH(name, bytes)                                                  \
+    static void Bench_##name(void);                                         \
+    static const bench_t USED SECTION("bench") ALIGNED(sizeof(void *))      \
+        bench_##name = { #name, Bench_##name, bytes };                      \
+    static void Bench_##name(void)
+#else
+#define BENCH(name, bytes)                                                  \
+    static void UNUSED Bench_##name(void)
+#endif
+
+/** make the compiler believe that the data pointed by x is used so that the
+ * benchmarked code is not optimized out */
+#define BENCH_KEEP(x)                                                       \
+    ASM volatile ("" : : "r" (x) : "memory")
+
+/**
+ * @brief run single benchmark
+ *
+ * @param b benchmark descriptor
+ * @param res results (already compensated for the measurement overhead)
+ *
+ * @return err_t error code
+ */
+err_t Bench_Run(const bench_t *b, bench_result_t *res);
+
+/**
+ * @brief run all registered benchmarks and print the results one line per
+ * benchmark
+ *
+ * @param out output function
+ *
+ * @return err_t error code
+ */
+err_t Bench_RunAll(bench_out_t out);
+
+/**
+ * @brief start the task that runs all of the benchmarks and sends the results
+ * over the usb serial port (target only)
+ *
+ * @return err_t error code
+ */
+err_t Bench_Init(void);
+
+#endif /* TEST_BENCH_H */
@@ -0,0 +1,226 @@
+/**
+ * @file bench.c
+ * @author Tomasz Watorowski (tomasz.watorowski@gmail.com)
+ * @date 2025-04-20
+ *
+ * @brief Host runner for the benchmarks from test/src/benchmarks.c. Every
+ * module is first checked against the known answers so that the optimized
+ * code is verified before it's timed.
+ *
+ * build & run (binary lands in .outs/host/bench):
+ *  make host_run
+ */
+
+#include <stdio.h>
+
+#include "net/dhcp/frame.h"
+#include "net/mdns/frame.h"
+#include "net/tcpip/checksum.h"
+#include "net/tcpip/sock_hash.h"
+#include "net/tcpip/tcp_opts.h"
+#include "net/uhttpsrv/parse.h"
+#include "sys/heap.h"
+#include "sys/msgq.h"
+#include "sys/queue.h"
+#include "test/bench.h"
+#include "util/base64.h"
+#include "util/sha1.h"
+#include "util/sha2.h"
+#include "util/stdio.h"
+#include "util/string.h"
+
+/* report the failed check */
+#define CHECK(x)                                                            \
+    do {                                                                    \
+        if (!(x)) {                                                         \
+            printf("check failed: %s:%d: %s\n", __FILE__, __LINE__, #x);    \
+            return -1;                                                      \
+        }                                                                   \
+    } while (0)
+
+/* text buffer */
+static char text[128];
+/* binary buffer */
+static uint8_t buf[512];
+
+/* utilities: hashes, encoders and formatting */
+static int Test_Util(void)
+{
+    /* sha state */
+    sha1_state_t s1; sha2_state_t s2;
+
+    /* sha1 of "abc" */
+    SHA1_InitState(&s1); SHA1_Digest(&s1, 1, "abc", 3);
+    SHA1_GetHashStr(&s1, text, sizeof(text));
+    CHECK(!strcmp(text, "a9993e364706816aba3e25717850c26c9cd0d89d"));
+    /* sha256 of "abc" */
+    SHA2_InitState(&s2, SHA2_TYPE_256); SHA2_Digest(&s2, 1, "abc", 3);
+    SHA2_GetHashStr(&s2, text, sizeof(text));
+    CHECK(!strcmp(text, "ba7816bf8f01cfea414140de5dae2223"
+        "b00361a396177a9cb410ff61f20015ad"));
+
+    /* base64 both ways */
+    CHECK(Base64_Encode("hello", 5, text, sizeof(text)) == 8);
+    CHECK(!memcmp(text, "aGVsbG8=", 8));
+    CHECK(Base64_Decode("aGVsbG8=", 8, buf, sizeof(buf)) == 5);
+    CHECK(!memcmp(buf, "hello", 5));
+
+    /* formatting */
+    snprintf(text, sizeof(text), "%s: %d %x", "len", -12, 0xbeef);
+    CHECK(!strcmp(text, "len: -12 beef"));
+
+    /* all good */
+    return 0;
+}
+
+/* system: heap and queues */
+static int Test_Sys(void)
+{
+    /* small block followed by the large one */
+    void *a = Heap_Malloc(16), *b = Heap_Malloc(256), *c;
+    CHECK(a && b);
+    /* release the small block and ask for the larger one: the small hole
+     * must not be picked */
+    Heap_Free(a); c = Heap_Malloc(64);
+    CHECK(c && c != a);
+    /* release the last block (no next block to relink) */
+    Heap_Free(c); Heap_Free(b);
+    CHECK(Heap_CheckIntegrity() == EOK);
+
+    /* byte queue */
+    queue_t *q = Queue_Create(1, 16);
+    CHECK(q);
+    CHECK(Queue_Put(q, "0123456789", 10) == 10);
+    CHECK(Queue_Get(q, text, 10) == 10 && !memcmp(text, "0123456789", 10));
+    /* reading at offset across the buffer wrap (tcp retransmissions) */
+    CHECK(Queue_Put(q, "abcdefghij", 10) == 10);
+    CHECK(Queue_PeekAt(q, 4, text, 16) == 6 && !memcmp(text, "efghij", 6));
+    CHECK(Queue_PeekAt(q, 10, text, 1) == 0 && Queue_GetUsed(q) == 10);
+    /* writing ahead of the head (tcp out-of-order segments) */
+    CHECK(Queue_PutAt(q, 2, "XYZWV", 5) == 4 && Queue_GetUsed(q) == 10);
+    CHECK(Queue_PutAt(q, 6, "X", 1) == 0);
+    CHECK(Queue_Put(q, "kl", 2) == 2 && Queue_Commit(q, 4) == 4);
+    CHECK(Queue_PeekAt(q, 10, text, 6) == 6 && !memcmp(text, "klXYZW", 6));
+    Queue_Destroy(q);
+
+    /* message queue */
+    msgq_t *mq = MsgQ_Create(64); uint32_t hdr = 0xcafe;
+    CHECK(mq);
+    CHECK(MsgQ_Put(mq, &hdr, sizeof(hdr), "abc", 3) == EOK);
+    hdr = 0;
+    CHECK(MsgQ_Get(mq, &hdr, sizeof(hdr), text, sizeof(text)) >= EOK);
+    CHECK(hdr == 0xcafe && !memcmp(text, "abc", 3));
+    /* header larger than the record is refused */
+    CHECK(MsgQ_Put(mq, &hdr, 2, 0, 0) == EOK);
+    CHECK(MsgQ_Get(mq, &hdr, sizeof(hdr), text, sizeof(text)) == EARGVAL);
+    CHECK(MsgQ_Get(mq, &hdr, 2, text, sizeof(text)) == 0);
+    MsgQ_Destroy(mq);
+
+    /* all good */
+    return 0;
+}
+
+/* network: checksum and frame codecs */
+static int Test_Net(void)
+{
+    /* ip header with valid checksum: sum over the whole header must fold
+     * into all ones */
+    static const uint8_t ip_hdr[] = { 0x45, 0x00, 0x00, 0x73, 0x00, 0x00,
+        0x40, 0x00, 0x40, 0x11, 0xb8, 0x61, 0xc0, 0xa8, 0x00, 0x01, 0xc0,
+        0xa8, 0x00, 0xc7 };
+    CHECK((uint16_t)~TCPIPChecksum_Checksum(0, ip_hdr, sizeof(ip_hdr)) == 0);
+
+    /* dhcp options round trip */
+    dhcp_optset_t opts = {
+        .optflags = DHCP_OPTFLAGS_MSGTYPE | DHCP_OPTFLAGS_LEASE_TIME |
+            DHCP_OPTFLAGS_END,
+        .msg_type = DHCP_MSG_TYPE_ACK, .lease_time = 3600,
+    }, parsed = { 0 };
+    uint8_t *end = DHCPFrame_RenderOptions(buf, sizeof(buf), &opts);
+    CHECK(end);
+    CHECK(DHCPFrame_ParseOptions(buf, end - buf, &parsed));
+    CHECK(parsed.msg_type == DHCP_MSG_TYPE_ACK && parsed.lease_time == 3600);
+
+    /* mdns name round trip */
+    mdns_frame_t *frame = (mdns_frame_t *)buf;
+    err_t ec = MDNSFrame_EncodeName("yield.local", frame->pld,
+        sizeof(buf) - sizeof(*frame));
+    CHECK(ec == 13);
+    CHECK(MDNSFrame_DecodeName(frame->pld, frame, sizeof(*frame) + ec, text,
+        sizeof(text)) == 13);
+    CHECK(!strcmp(text, "yield.local"));
+
+    /* socket lookup table sizing and bucket ranges */
+    CHECK(TCPIPSockHash_GetSize(1) == 2 && TCPIPSockHash_GetSize(24) == 64);
+    CHECK(TCPIPSockHash_Conn((tcpip_ip_addr_t)TCPIP_IP_ADDR(192, 168, 50, 124),
+        50000, 80, 64) < 64 && TCPIPSockHash_Port(80, 64) < 64);
+
+    /* tcp options round trip, unknown options are skipped */
+    tcpip_tcp_opts_t tcp_opts = { .flags = TCPIP_TCP_OPTS_MSS |
+        TCPIP_TCP_OPTS_WSCALE | TCPIP_TCP_OPTS_TS, .mss = 1460, .wscale = 7,
+        .ts_val = 0x12345678, .ts_ecr = 0x9abcdef0 }, tcp_parsed;
+    size_t tcp_opts_size = TCPIPTcpOpts_Render(buf, &tcp_opts);
+    CHECK(tcp_opts_size == 20 && TCPIPTcpOpts_GetSize(&tcp_opts) == 20);
+    buf[tcp_opts_size++] = 30, buf[tcp_opts_size++] = 2;
+    CHECK(TCPIPTcpOpts_Parse(buf, tcp_opts_size, &tcp_parsed) == EOK);
+    CHECK(tcp_parsed.flags == tcp_opts.flags && tcp_parsed.mss == 1460 &&
+        tcp_parsed.wscale == 7 && tcp_parsed.ts_val == 0x12345678 &&
+        tcp_parsed.ts_ecr == 0x9abcdef0);
+    /* option that does not fit */
+    CHECK(TCPIPTcpOpts_Parse(buf, 3, &tcp_parsed) == EMALFORMED);
+    /* sack blocks */
+    tcp_opts = (tcpip_tcp_opts_t) { .flags = TCPIP_TCP_OPTS_SACK,
+        .sack_num = 2, .sack = { { 100, 200 }, { 300, 400 } } };
+    tcp_opts_size = TCPIPTcpOpts_Render(buf, &tcp_opts);
+    CHECK(tcp_opts_size == 20 && TCPIPTcpOpts_GetSize(&tcp_opts) == 20);
+    CHECK(TCPIPTcpOpts_Parse(buf, tcp_opts_size, &tcp_parsed) == EOK);
+    CHECK(tcp_parsed.flags == TCPIP_TCP_OPTS_SACK && tcp_parsed.sack_num == 2 &&
+        tcp_parsed.sack[1].start == 300 && tcp_parsed.sack[1].end == 400);
+
+    /* all good */
+    return 0;
+}
+
+/* http server parsers */
+static int Test_UHTTPSrv(void)
+{
+    /* parsed request line */
+    enum uhttp_method method; enum uhttp_version version; char url[32];
+    /* parsed field */
+    uhttp_field_t field;
+
+    /* request line */
+    CHECK(UHTTPSrv_ParseRequestLine("GET /index.html HTTP/1.1", 24, &method,
+        url, sizeof(url), &version) == EOK);
+    CHECK(method == HTTP_METHOD_GET && version == HTTP_VER_1V1);
+    CHECK(!strcmp(url, "/index.html"));
+    /* unknown version is an error */
+    CHECK(UHTTPSrv_ParseRequestLine("GET / HTTP/9.9", 14, &method,
+        url, sizeof(url), &version) != EOK);
+
+    /* integer field */
+    CHECK(UHTTPSrv_ParseFieldLine("Content-Length: 12345", 21, &field) == EOK);
+    CHECK(field.name == HTTP_FIELD_NAME_CONTENT_LENGTH &&
+        field.value.i == 12345);
+
+    /* all good */
+    return 0;
+}
+
+/* print the results to the standard output */
+static void Bench_StdOut(const char *str, size_t len)
+{
+    fwrite(str, 1, len, stdout);
+}
+
+/* checks & benchmarks entry point */
+int main(void)
+{
+    /* known answer checks */
+    if (Test_Util() || Test_Sys() || Test_Net() || Test_UHTTPSrv())
+        return -1;
+    printf("checks passed\n");
+
+    /* benchmarks */
+    return Bench_RunAll(Bench_StdOut) == EOK ? 0 : -1;
+}
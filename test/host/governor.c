@@ -0,0 +1,114 @@
+/**
+ * @file governor.c
+ * @author Tomasz Watorowski (tomasz.watorowski@gmail.com)
+ * @date 2025-04-24
+ *
+ * @brief Host test: clock governor policy replayed against synthetic load
+ * traces. Work demand is expressed as a fraction of the full speed clock, so
+ * the load measured at given level is the demand times 2^level (capped at 1).
+ * Checks that bursts bring the clock up at once, idle brings it down to the
+ * lowest level and steady load does not make it oscillate.
+ *
+ * build & run (binary lands in .outs/host/governor):
+ *  make host_run
+ */
+
+#include <stdio.h>
+
+#include "config.h"
+#include "sys/governor.h"
+
+/* number of clock levels under test */
+#define TEST_LEVELS                         3
+/* number of cycles per period at full speed (100ms at 84MHz) */
+#define TEST_CYCLES                         8400000
+
+/* number of errors */
+static int errors;
+
+/* run single governor period with given demand (in permille of full speed),
+ * returns the level for the next period */
+static int Test_Period(governor_t *g, uint32_t demand)
+{
+    /* cycles available at current level */
+    uint32_t total = TEST_CYCLES >> g->level;
+    /* load measured at current level */
+    uint64_t busy = (uint64_t)TEST_CYCLES * demand / 1000;
+
+    /* cannot be busier than all of the time */
+    if (busy > total)
+        busy = total;
+    /* let the governor decide */
+    return Governor_Decide(g, busy, total);
+}
+
+/* replay a trace, return the number of level changes */
+static int Test_Trace(governor_t *g, const uint32_t *trace, int len)
+{
+    /* level changes */
+    int changes = 0;
+
+    /* replay */
+    for (int i = 0; i < len; i++) {
+        int prev = g->level;
+        if (Test_Period(g, trace[i]) != prev)
+            changes++;
+    }
+
+    /* report */
+    return changes;
+}
+
+/* test entry point */
+int main(void)
+{
+    /* governor under test */
+    governor_t g;
+    /* test traces */
+    uint32_t idle[40], steady[40], bursty[40];
+
+    /* idle system: demand at 5%, shall end up at the lowest level */
+    for (int i = 0; i < 40; i++)
+        idle[i] = 50;
+    Governor_Init(&g, TEST_LEVELS);
+    Test_Trace(&g, idle, 40);
+    if (g.level != TEST_LEVELS - 1)
+        errors++;
+    printf("idle: level %d\n", g.level);
+
+    /* burst while being idle: full speed within one period */
+    uint32_t burst = 950;
+    Test_Trace(&g, &burst, 1);
+    if (g.level != 0)
+        errors++;
+    printf("burst: level %d\n", g.level);
+
+    /* steady load at 25%: the lower level would be at 50% which is below the
+     * up threshold, the governor shall settle and stay there */
+    for (int i = 0; i < 40; i++)
+        steady[i] = 250;
+    Governor_Init(&g, TEST_LEVELS);
+    Test_Trace(&g, steady, 20);
+    int changes = Test_Trace(&g, steady + 20, 20);
+    if (changes)
+        errors++;
+    printf("steady: level %d, changes after settling %d\n", g.level, changes);
+
+    /* load that alternates between 5% and 40%: must not go down on a single
+     * quiet period and must not flip back and forth */
+    for (int i = 0; i < 40; i++)
+        bursty[i] = i % 2 ? 400 : 50;
+    Governor_Init(&g, TEST_LEVELS);
+    changes = Test_Trace(&g, bursty, 40);
+    if (changes > 2)
+        errors++;
+    printf("bursty: level %d, changes %d\n", g.level, changes);
+
+    /* nothing measured: level is kept */
+    Governor_Init(&g, TEST_LEVELS);
+    if (Governor_Decide(&g, 0, 0) != 0)
+        errors++;
+
+    printf("errors %d\n", errors);
+    return errors ? -1 : 0;
+}
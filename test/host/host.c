@@ -0,0 +1,118 @@
+/**
+ * @file host.c
+ * @author Tomasz Watorowski (tomasz.watorowski@gmail.com)
+ * @date 2025-04-02
+ *
+ * @brief Host (linux) replacements for the system services
+ */
+
+/* clock_gettime() & friends */
+#define _POSIX_C_SOURCE 200809L
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "config.h"
+#include "test/host/host.h"
+
+/* thread handles */
+static pthread_t threads[16]; static int threads_num;
+
+/* dynamic memory is served by sys/src/heap.c, it needs to be initialized
+ * before main() */
+extern int Heap_Init(void *ptr, size_t size);
+static uint64_t host_heap[SYS_HEAP_SIZE / sizeof(uint64_t)];
+static void __attribute__((constructor)) Host_HeapInit(void)
+{
+    Heap_Init(host_heap, sizeof(host_heap));
+}
+
+/* failed assertions end the program */
+void Reset_ResetMCU(void) { abort(); }
+
+/* there is only one task per thread, so yielding means yielding the cpu */
+void Yield(void) { sched_yield(); }
+int Yield_IsCancelled(void) { return 0; }
+int Yield_GetTaskID(void) { return 1; }
+
+/* task routine with its argument */
+struct host_task { void (*handler)(void *); void *arg; };
+
+/* thread routine that calls the task handler */
+static void * Host_TaskRoutine(void *ptr)
+{
+    /* copy the task and release the memory */
+    struct host_task t = *(struct host_task *)ptr; free(ptr);
+    /* run the task */
+    t.handler(t.arg); return 0;
+}
+
+/* tasks are started as threads */
+int Yield_Task(void (*handler)(void *), void *arg, size_t stack_size)
+{
+    /* task routine with its argument, kept until the thread starts */
+    struct host_task *task = malloc(sizeof(*task));
+    /* no memory */
+    if (!task)
+        return -1;
+    /* start the thread */
+    task->handler = handler, task->arg = arg;
+    if (Host_ThreadStart(Host_TaskRoutine, task) < 0) {
+        free(task); return -1;
+    }
+    /* report status */
+    return 0;
+}
+
+/* system time in ms */
+uint32_t Time_GetTime(void)
+{
+    /* use the monotonic clock */
+    struct timespec ts; clock_gettime(CLOCK_MONOTONIC, &ts);
+    /* convert to ms */
+    return ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+/* system time in us */
+uint64_t Time_GetTimeUS(void)
+{
+    /* use the monotonic clock */
+    struct timespec ts; clock_gettime(CLOCK_MONOTONIC, &ts);
+    /* convert to us */
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/* nanosecond timestamp */
+uint64_t Host_GetTimeNS(void)
+{
+    /* use the monotonic clock */
+    struct timespec ts; clock_gettime(CLOCK_MONOTONIC, &ts);
+    /* convert to ns */
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/* run the routine in a separate thread */
+int Host_ThreadStart(host_thread_t routine, void *arg)
+{
+    /* no more space for handles */
+    if (threads_num == sizeof(threads) / sizeof(threads[0]))
+        return -1;
+    /* start the thread */
+    if (pthread_create(&threads[threads_num], 0, routine, arg))
+        return -1;
+    /* return the handle */
+    return threads_num++;
+}
+
+/* wait for the thread to finish */
+void * Host_ThreadJoin(int handle)
+{
+    /* thread result */
+    void *result = 0;
+    /* wait for the thread */
+    pthread_join(threads[handle], &result);
+    return result;
+}
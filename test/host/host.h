@@ -0,0 +1,45 @@
+/**
+ * @file host.h
+ * @author Tomasz Watorowski (tomasz.watorowski@gmail.com)
+ * @date 2025-04-02
+ *
+ * @brief Host (linux) replacements for the system services so that portable
+ * modules can be tested without the hardware. Kept apart from the tests since
+ * libc headers clash with the system ones (e.g. time_t, time()).
+ */
+
+#ifndef TEST_HOST_HOST_H
+#define TEST_HOST_HOST_H
+
+#include <stdint.h>
+
+/** thread routine */
+typedef void * (* host_thread_t)(void *arg);
+
+/**
+ * @brief run the routine in a separate thread
+ *
+ * @param routine thread routine
+ * @param arg routine argument
+ *
+ * @return int thread handle or negative number in case of an error
+ */
+int Host_ThreadStart(host_thread_t routine, void *arg);
+
+/**
+ * @brief wait for the thread to finish
+ *
+ * @param handle thread handle as returned by Host_ThreadStart()
+ *
+ * @return void * value returned by the thread routine
+ */
+void * Host_ThreadJoin(int handle);
+
+/**
+ * @brief monotonic timestamp with nanosecond resolution, for benchmarks
+ *
+ * @return uint64_t timestamp in ns
+ */
+uint64_t Host_GetTimeNS(void);
+
+#endif /* TEST_HOST_HOST_H */
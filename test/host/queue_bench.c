@@ -0,0 +1,99 @@
+/**
+ * @file queue_bench.c
+ * @author Tomasz Watorowski (tomasz.watorowski@gmail.com)
+ * @date 2025-04-05
+ *
+ * @brief Host benchmark: generic queue_t vs compile-time typed queue
+ *
+ * build & run (binary lands in .outs/host/queue_bench):
+ *  make host_run
+ */
+
+#include <stdio.h>
+
+#include "sys/queue.h"
+#include "sys/tqueue.h"
+#include "test/host/host.h"
+
+/* number of elements passed through each queue */
+#define BENCH_ELEMS                         (50 * 1000 * 1000)
+/* queue capacity */
+#define BENCH_CAPACITY                      64
+
+/* typed queue under test */
+QUEUE_DECLARE(tq, uint32_t, BENCH_CAPACITY)
+
+/* pass the data through the generic queue, element by element and in
+ * chunks */
+static uint32_t Bench_Generic(queue_t *q, size_t chunk)
+{
+    /* transfer buffer and the checksum */
+    uint32_t buf[16], sum = 0;
+
+    for (uint32_t i = 0; i < BENCH_ELEMS; i += chunk) {
+        for (size_t j = 0; j < chunk; j++)
+            buf[j] = i + j;
+        Queue_Put(q, buf, chunk);
+        Queue_Get(q, buf, chunk);
+        for (size_t j = 0; j < chunk; j++)
+            sum += buf[j];
+    }
+
+    return sum;
+}
+
+/* pass the data through the typed queue */
+static uint32_t Bench_Typed(size_t chunk)
+{
+    /* transfer buffer and the checksum */
+    uint32_t buf[16], sum = 0;
+
+    for (uint32_t i = 0; i < BENCH_ELEMS; i += chunk) {
+        for (size_t j = 0; j < chunk; j++)
+            buf[j] = i + j;
+        tq_Put(buf, chunk);
+        tq_Get(buf, chunk);
+        for (size_t j = 0; j < chunk; j++)
+            sum += buf[j];
+    }
+
+    return sum;
+}
+
+/* single element variant of the typed queue */
+static uint32_t Bench_TypedOne(void)
+{
+    /* the checksum */
+    uint32_t v = 0, sum = 0;
+
+    for (uint32_t i = 0; i < BENCH_ELEMS; i++) {
+        tq_PutOne(i); tq_GetOne(&v); sum += v;
+    }
+
+    return sum;
+}
+
+/* benchmark entry point */
+int main(void)
+{
+    /* generic queue */
+    queue_t *q = Queue_Create(sizeof(uint32_t), BENCH_CAPACITY);
+    /* timestamps and checksums */
+    uint64_t ts; uint32_t sum;
+
+    for (size_t chunk = 1; chunk <= 16; chunk *= 4) {
+        ts = Host_GetTimeNS(); sum = Bench_Generic(q, chunk);
+        printf("queue_t  chunk %2zu: %6.2f ns/elem (sum %08x)\n", chunk,
+            (double)(Host_GetTimeNS() - ts) / BENCH_ELEMS, sum);
+        ts = Host_GetTimeNS(); sum = Bench_Typed(chunk);
+        printf("tqueue   chunk %2zu: %6.2f ns/elem (sum %08x)\n", chunk,
+            (double)(Host_GetTimeNS() - ts) / BENCH_ELEMS, sum);
+    }
+
+    ts = Host_GetTimeNS(); sum = Bench_TypedOne();
+    printf("tqueue   put/get one: %6.2f ns/elem (sum %08x)\n",
+        (double)(Host_GetTimeNS() - ts) / BENCH_ELEMS, sum);
+
+    Queue_Destroy(q);
+    return 0;
+}
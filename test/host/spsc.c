@@ -0,0 +1,111 @@
+/**
+ * @file spsc.c
+ * @author Tomasz Watorowski (tomasz.watorowski@gmail.com)
+ * @date 2025-04-02
+ *
+ * @brief Host stress test for the spsc queue: producer and consumer are run
+ * as two separate threads that hammer the queue with sequence numbers.
+ *
+ * build & run (binary lands in .outs/host/spsc):
+ *  make host_run
+ */
+
+#include <stdio.h>
+
+#include "sys/spsc.h"
+#include "sys/yield.h"
+#include "test/host/host.h"
+
+/* number of elements passed through the queue */
+#define TEST_ELEMS                          (20 * 1000 * 1000)
+/* queue capacity (power of two), chunks of other sizes exercise the
+ * wrapping */
+#define TEST_CAPACITY                       64
+/* maximal chunk size used by both sides */
+#define TEST_MAX_CHUNK                      17
+
+/* queue under test and it's storage */
+static spsc_t q; static uint32_t buf[TEST_CAPACITY];
+/* number of wakeup callbacks */
+static volatile uint32_t wakeups;
+
+/* producer wakeup callback */
+static void Test_PutCallback(void *arg)
+{
+    __atomic_add_fetch(&wakeups, 1, __ATOMIC_RELAXED);
+}
+
+/* producer thread */
+static void * Test_Producer(void *arg)
+{
+    /* chunk buffer, sequence number, pseudo random chunk size */
+    uint32_t chunk[TEST_MAX_CHUNK], seq = 0, rnd = 1;
+
+    while (seq != TEST_ELEMS) {
+        /* pick the chunk size */
+        rnd = rnd * 1103515245 + 12345;
+        size_t size = 1 + (rnd >> 16) % TEST_MAX_CHUNK;
+        if (size > TEST_ELEMS - seq)
+            size = TEST_ELEMS - seq;
+        /* fill in the chunk */
+        for (size_t i = 0; i < size; i++)
+            chunk[i] = seq + i;
+        /* put it into the queue, retry with what was not accepted */
+        for (size_t put = 0; put != size; Yield())
+            put += Spsc_Put(&q, chunk + put, size - put);
+        seq += size;
+    }
+
+    return 0;
+}
+
+/* consumer thread */
+static void * Test_Consumer(void *arg)
+{
+    /* chunk buffer, expected sequence number, pseudo random chunk size */
+    uint32_t chunk[TEST_MAX_CHUNK], seq = 0, rnd = 7;
+    /* number of errors */
+    uintptr_t errors = 0;
+
+    while (seq != TEST_ELEMS) {
+        /* pick the chunk size */
+        rnd = rnd * 1103515245 + 12345;
+        size_t size = Spsc_Get(&q, chunk, 1 + (rnd >> 16) % TEST_MAX_CHUNK);
+        /* validate the sequence */
+        for (size_t i = 0; i < size; i++, seq++)
+            if (chunk[i] != seq && errors++ < 10)
+                fprintf(stderr, "mismatch: got %u, expected %u\n", chunk[i],
+                    seq);
+        /* nothing to do */
+        if (!size)
+            Yield();
+    }
+
+    return (void *)errors;
+}
+
+/* test entry point */
+int main(void)
+{
+    /* thread handles and the result */
+    int prod, cons; void *errors;
+
+    /* setup the queue */
+    Spsc_Init(&q, buf, sizeof(buf[0]), TEST_CAPACITY);
+    Spsc_SetPutCallback(&q, Test_PutCallback, 0);
+    /* start close to the end of the counter range so that the counters wrap
+     * during the test */
+    q.head = q.tail = UINT32_MAX - TEST_ELEMS / 2;
+
+    /* run both sides */
+    cons = Host_ThreadStart(Test_Consumer, 0);
+    prod = Host_ThreadStart(Test_Producer, 0);
+    Host_ThreadJoin(prod);
+    errors = Host_ThreadJoin(cons);
+
+    /* report */
+    printf("spsc: %u elements, %u wakeups, %u errors, %u left\n",
+        TEST_ELEMS, wakeups, (unsigned)(uintptr_t)errors,
+        (unsigned)Spsc_GetUsed(&q));
+    return errors || Spsc_GetUsed(&q) ? 1 : 0;
+}
@@ -0,0 +1,90 @@
+/**
+ * @file time_bench.c
+ * @author Tomasz Watorowski (tomasz.watorowski@gmail.com)
+ * @date 2025-04-14
+ *
+ * @brief Host benchmark & check: systick count to time conversion with
+ * division (old way) vs reciprocal multiplication (Time_Scale())
+ *
+ * build & run (binary lands in .outs/host/time_bench):
+ *  make host_run
+ */
+
+#include <stdio.h>
+
+#include "config.h"
+#include "sys/time.h"
+#include "test/host/host.h"
+
+/* number of conversions done in the benchmark */
+#define BENCH_ITERS                         (100 * 1000 * 1000)
+
+/* systick reload value as used by the target */
+static volatile uint32_t reload = (AHBCLOCK_HZ / 8) - 1;
+
+/* check that the conversion is exact (or a single unit behind), monotonic
+ * and never reaches the full second */
+static int Check_Conversion(uint32_t freq, uint32_t units)
+{
+    /* conversion factor */
+    uint32_t mult = Time_ReciprocalMult(units, freq);
+    /* previous value, number of inexact conversions */
+    uint32_t prev = 0, inexact = 0;
+
+    for (uint32_t cnt = 0; cnt < freq; cnt++) {
+        /* reference and the fast value */
+        uint32_t ref = (uint64_t)cnt * units / freq;
+        uint32_t fast = Time_Scale(cnt, mult);
+        /* must not run ahead nor fall behind by more than a single unit */
+        if (fast > ref || fast + 1 < ref || fast < prev || fast >= units) {
+            printf("conversion error: freq %u, cnt %u, ref %u, fast %u\n",
+                freq, cnt, ref, fast);
+            return -1;
+        }
+        /* count the ones that are not exact */
+        inexact += fast != ref; prev = fast;
+    }
+
+    printf("freq %9u Hz -> %7u units/s: ok, %u inexact\n", freq, units,
+        inexact);
+    return 0;
+}
+
+/* benchmark entry point */
+int main(void)
+{
+    /* timestamps and checksums */
+    uint64_t ts; uint32_t sum = 0;
+    /* conversion factor */
+    uint32_t mult = Time_ReciprocalMult(1000, reload + 1);
+
+    /* check the conversions for the clocks that we may run at */
+    for (uint32_t mhz = 16; mhz <= 84; mhz += 4) {
+        if (Check_Conversion(mhz * 1000000 / 8, 1000000) ||
+            Check_Conversion(mhz * 1000000 / 8, 1000))
+            return -1;
+    }
+
+    /* old way: division on every call */
+    ts = Host_GetTimeNS();
+    for (uint32_t i = 0; i < BENCH_ITERS; i++)
+        sum += (i & 0xffffff) / (reload / 1000);
+    printf("division:   %6.2f ns/call (sum %08x)\n",
+        (double)(Host_GetTimeNS() - ts) / BENCH_ITERS, sum);
+
+    /* new way: multiply and shift */
+    ts = Host_GetTimeNS();
+    for (uint32_t i = 0; i < BENCH_ITERS; i++)
+        sum += Time_Scale(i & 0xffffff, mult);
+    printf("reciprocal: %6.2f ns/call (sum %08x)\n",
+        (double)(Host_GetTimeNS() - ts) / BENCH_ITERS, sum);
+
+    /* cost of the full timestamp read */
+    ts = Host_GetTimeNS();
+    for (uint32_t i = 0; i < BENCH_ITERS / 100; i++)
+        sum += time_us(0);
+    printf("time_us():  %6.2f ns/call (sum %08x)\n",
+        (double)(Host_GetTimeNS() - ts) / (BENCH_ITERS / 100), sum);
+
+    return 0;
+}
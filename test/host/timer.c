@@ -0,0 +1,90 @@
+/**
+ * @file timer.c
+ * @author Tomasz Watorowski (tomasz.watorowski@gmail.com)
+ * @date 2025-04-16
+ *
+ * @brief Host test: software timers fire in order, never early, periodic ones
+ * keep firing and stopped ones do not fire at all
+ *
+ * build & run (binary lands in .outs/host/timer):
+ *  make host_run
+ */
+
+#include <stdio.h>
+
+#include "config.h"
+#include "sys/time.h"
+#include "sys/timer.h"
+
+/* number of single shot timers */
+#define TEST_TIMERS                         (SYS_TIMER_MAX_NUM - 1)
+
+/* timers under test */
+static systimer_t timers[TEST_TIMERS], periodic, stopped;
+/* number of callbacks called, errors */
+static int fired, periodic_fired, errors;
+/* expiration time of the most recently fired single shot timer */
+static time_t last;
+
+/* single shot timer callback */
+static void Test_Callback(void *arg)
+{
+    /* timer that has fired */
+    systimer_t *t = arg;
+
+    /* must not fire early or out of order */
+    if (dtime(time(0), t->expires) < 0 || (fired && dtime(t->expires, last) < 0))
+        errors++;
+    /* single shot timers are stopped when called */
+    if (Timer_IsRunning(t))
+        errors++;
+    last = t->expires; fired++;
+}
+
+/* periodic timer callback */
+static void Test_PeriodicCallback(void *arg)
+{
+    periodic_fired++;
+}
+
+/* stopped timer callback */
+static void Test_StoppedCallback(void *arg)
+{
+    errors++;
+}
+
+/* test entry point */
+int main(void)
+{
+    /* pseudo random delay generator */
+    uint32_t seed = 1;
+
+    /* start timers with random delays up to 200ms */
+    for (int i = 0; i < TEST_TIMERS; i++) {
+        seed = seed * 1103515245 + 12345;
+        Timer_Start(&timers[i], Test_Callback, &timers[i], seed % 200, 0);
+    }
+    /* restart some of them so that removal from the middle is covered */
+    for (int i = 0; i < TEST_TIMERS; i += 3)
+        Timer_Start(&timers[i], Test_Callback, &timers[i], 100 + i, 0);
+    /* periodic timer and the one that is stopped before it fires */
+    Timer_Start(&periodic, Test_PeriodicCallback, 0, 10, 10);
+    Timer_Start(&stopped, Test_StoppedCallback, 0, 50, 0);
+    Timer_Stop(&stopped);
+
+    /* no space left */
+    systimer_t extra = { 0 };
+    if (Timer_Start(&extra, Test_StoppedCallback, 0, 0, 0) != EBUSY)
+        errors++;
+
+    /* run for 300ms */
+    for (time_t ts = time(0); dtime_now(ts) < 300; )
+        Timer_Poll();
+    /* only the periodic one shall remain */
+    Timer_Stop(&periodic);
+
+    printf("fired %d/%d, periodic fired %d times, errors %d\n", fired,
+        TEST_TIMERS, periodic_fired, errors);
+    return fired == TEST_TIMERS && periodic_fired >= 25 &&
+        periodic_fired <= 30 && !errors ? 0 : -1;
+}
@@ -0,0 +1,163 @@
+/**
+ * @file bench.c
+ * @author Tomasz Watorowski (tomasz.watorowski@gmail.com)
+ * @date 2025-04-20
+ *
+ * @brief Microbenchmark harness
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "config.h"
+#include "compiler.h"
+#include "err.h"
+#include "test/bench.h"
+#include "util/stdio.h"
+
+#ifdef __arm__
+#include "dev/usb_vcp.h"
+#include "stm32f401/dwt.h"
+#include "sys/sleep.h"
+#include "sys/yield.h"
+/* unit of measurement */
+#define BENCH_UNIT                          "cycles"
+#else
+#include "test/host/host.h"
+/* unit of measurement */
+#define BENCH_UNIT                          "ns"
+#endif
+
+/* registered benchmarks, section boundaries are provided by the linker */
+extern const bench_t __start_bench[], __stop_bench[];
+
+/* iteration timestamps */
+static uint32_t samples[BENCH_ITERATIONS];
+
+/* read the counter */
+static inline ALWAYS_INLINE uint32_t Bench_GetCount(void)
+{
+    #ifdef __arm__
+        return DWT->CYCCNT;
+    #else
+        return Host_GetTimeNS();
+    #endif
+}
+
+/* measure the benchmark without the overhead compensation */
+static void Bench_Measure(void (*func)(void), bench_result_t *res)
+{
+    /* warm up the caches, branch predictors etc. */
+    for (int i = 0; i < BENCH_WARMUP; i++)
+        func();
+
+    /* measure every iteration separately */
+    for (int i = 0; i < BENCH_ITERATIONS; i++) {
+        uint32_t ts = Bench_GetCount();
+        func();
+        samples[i] = Bench_GetCount() - ts;
+    }
+
+    /* sort (insertion sort is fine for that small number of samples) */
+    for (int i = 1; i < BENCH_ITERATIONS; i++) {
+        uint32_t v = samples[i]; int j;
+        for (j = i; j > 0 && samples[j - 1] > v; j--)
+            samples[j] = samples[j - 1];
+        samples[j] = v;
+    }
+
+    /* store the results */
+    res->min = samples[0];
+    res->median = samples[BENCH_ITERATIONS / 2];
+}
+
+/* empty benchmark used for estimating the measurement overhead */
+static void NOINLINE Bench_Empty(void)
+{
+    ASM volatile ("" : : : "memory");
+}
+
+/* run single benchmark */
+err_t Bench_Run(const bench_t *b, bench_result_t *res)
+{
+    /* measurement overhead */
+    bench_result_t overhead;
+
+    /* measure the overhead and the benchmark itself */
+    Bench_Measure(Bench_Empty, &overhead);
+    Bench_Measure(b->func, res);
+
+    /* compensate */
+    res->min = res->min > overhead.min ? res->min - overhead.min : 0;
+    res->median = res->median > overhead.min ? res->median - overhead.min : 0;
+    /* report status */
+    return EOK;
+}
+
+/* run all registered benchmarks */
+err_t Bench_RunAll(bench_out_t out)
+{
+    /* output line */
+    char line[96]; int len;
+    /* results */
+    bench_result_t res;
+
+    #ifdef __arm__
+        /* enable the cycle counter (if not already running), it is shared
+         * with the load accounting so it is never reset, all measurements
+         * are deltas */
+        DCB->DEMCR |= DCB_DEMCR_TRCENA;
+        DWT->CTRL |= DWT_CTRL_CYCCNTENA;
+    #endif
+
+    /* header */
+    len = snprintf(line, sizeof(line), "bench: %d iterations, unit: %s\n",
+        BENCH_ITERATIONS, BENCH_UNIT);
+    out(line, len);
+
+    /* go through all the benchmarks */
+    for (const bench_t *b = __start_bench; b != __stop_bench; b++) {
+        /* run the benchmark */
+        Bench_Run(b, &res);
+        /* format the results, add the per byte cost (x100) if applicable */
+        len = snprintf(line, sizeof(line), "bench: %-24s min %8u median %8u",
+            b->name, res.min, res.median);
+        if (b->bytes)
+            len += snprintf(line + len, sizeof(line) - len, " (%u.%02u/B)",
+                res.median / b->bytes, res.median * 100 / b->bytes % 100);
+        len += snprintf(line + len, sizeof(line) - len, "\n");
+        out(line, len);
+    }
+
+    /* report status */
+    return EOK;
+}
+
+#ifdef __arm__
+
+/* send the results over the usb serial port */
+static void Bench_VCPOut(const char *str, size_t len)
+{
+    USBVCP_Send(str, len, 0);
+}
+
+/* benchmarking task */
+static void Bench_Task(void *arg)
+{
+    /* give the host some time to open the serial port */
+    Sleep(5000);
+    /* run everything */
+    Bench_RunAll(Bench_VCPOut);
+}
+
+/* start the benchmarking task */
+err_t Bench_Init(void)
+{
+    /* start the task */
+    if (Yield_Task(Bench_Task, 0, 2048) < EOK)
+        return EFATAL;
+    /* report status */
+    return EOK;
+}
+
+#endif
@@ -0,0 +1,217 @@
+/**
+ * @file benchmarks.c
+ * @author Tomasz Watorowski (tomasz.watorowski@gmail.com)
+ * @date 2025-04-20
+ *
+ * @brief Benchmarks of the routines that are on the hot paths
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "net/dhcp/frame.h"
+#include "net/mdns/frame.h"
+#include "net/tcpip/checksum.h"
+#include "net/uhttpsrv/parse.h"
+#include "sys/heap.h"
+#include "sys/msgq.h"
+#include "sys/queue.h"
+#include "test/bench.h"
+#include "util/base64.h"
+#include "util/jenkins.h"
+#include "util/sha1.h"
+#include "util/sha2.h"
+#include "util/stdio.h"
+#include "util/string.h"
+
+/* source and destination buffers (size of the full ethernet frame payload) */
+static uint8_t ALIGNED(4) src[1500], dst[1500];
+/* text buffer */
+static char text[128];
+
+/* aligned copy of the full frame */
+BENCH(memcpy_1500, sizeof(src))
+{
+    memcpy(dst, src, sizeof(src)); BENCH_KEEP(dst);
+}
+
+/* unaligned copy */
+BENCH(memcpy_1499_unaligned, sizeof(src) - 1)
+{
+    memcpy(dst + 1, src, sizeof(src) - 1); BENCH_KEEP(dst);
+}
+
+/* small copy, typical for the headers */
+BENCH(memcpy_20, 20)
+{
+    memcpy(dst, src, 20); BENCH_KEEP(dst);
+}
+
+/* internet checksum over the full tcp segment */
+BENCH(checksum_1460, 1460)
+{
+    uint16_t sum = TCPIPChecksum_Checksum(0, src, 1460); BENCH_KEEP(sum);
+}
+
+/* internet checksum over the header */
+BENCH(checksum_20, 20)
+{
+    uint16_t sum = TCPIPChecksum_Checksum(0, src, 20); BENCH_KEEP(sum);
+}
+
+/* sha1 over the websocket handshake sized message */
+BENCH(sha1_60, 60)
+{
+    sha1_state_t s;
+    SHA1_InitState(&s); SHA1_Digest(&s, 1, src, 60); BENCH_KEEP(&s);
+}
+
+/* sha1 over larger buffer */
+BENCH(sha1_1024, 1024)
+{
+    sha1_state_t s;
+    SHA1_InitState(&s); SHA1_Digest(&s, 1, src, 1024); BENCH_KEEP(&s);
+}
+
+/* typical http header formatting */
+BENCH(snprintf_header, 0)
+{
+    snprintf(text, sizeof(text), "%s: %d\r\n", "Content-Length", 12345);
+    BENCH_KEEP(text);
+}
+
+/* hex & padding formatting */
+BENCH(snprintf_hex, 0)
+{
+    snprintf(text, sizeof(text), "%08x %-10s %5u", 0xdeadbeef, "abc", 42u);
+    BENCH_KEEP(text);
+}
+
+/* allocation and release of the small block */
+BENCH(heap_malloc_free_64, 0)
+{
+    void *ptr = Heap_Malloc(64); BENCH_KEEP(ptr); Heap_Free(ptr);
+}
+
+/* allocation pattern that fragments the heap: three blocks of different
+ * sizes released out of order */
+BENCH(heap_fragmented_3, 0)
+{
+    void *a = Heap_Malloc(24), *b = Heap_Malloc(200), *c = Heap_Malloc(64);
+    BENCH_KEEP(a); BENCH_KEEP(b); BENCH_KEEP(c);
+    Heap_Free(b); Heap_Free(a); Heap_Free(c);
+}
+
+/* sha256 over larger buffer */
+BENCH(sha256_1024, 1024)
+{
+    sha2_state_t s;
+    SHA2_InitState(&s, SHA2_TYPE_256); SHA2_Digest(&s, 1, src, 1024);
+    BENCH_KEEP(&s);
+}
+
+/* base64 encoding, 768 bytes in produce 1024 bytes out */
+BENCH(base64_encode_768, 768)
+{
+    err_t ec = Base64_Encode(src, 768, dst, sizeof(dst)); BENCH_KEEP(ec);
+}
+
+/* base64 decoding of the websocket key sized string */
+BENCH(base64_decode_24, 24)
+{
+    err_t ec = Base64_Decode("dGhlIHNhbXBsZSBub25jZQ==", 24, dst, sizeof(dst));
+    BENCH_KEEP(ec);
+}
+
+/* jenkins hash of the short key (e.g. file name) */
+BENCH(jenkins_oaat_32, 32)
+{
+    uint32_t h = Jenkins_OAAT(0, src, 32); BENCH_KEEP(h);
+}
+
+/* byte queue: put and get the chunk of data */
+BENCH(queue_put_get_64, 64)
+{
+    /* queue is allocated on first use and then reused */
+    static queue_t *q; if (!q && !(q = Queue_Create(1, 256))) return;
+    /* pass the data through */
+    Queue_Put(q, src, 64); Queue_Get(q, dst, 64); BENCH_KEEP(dst);
+}
+
+/* message queue: put and get the single record */
+BENCH(msgq_put_get_64, 64)
+{
+    /* queue is allocated on first use and then reused */
+    static msgq_t *mq; if (!mq && !(mq = MsgQ_Create(256))) return;
+    /* header that goes along with the data */
+    uint32_t hdr = 0xcafe;
+    /* pass the data through */
+    MsgQ_Put(mq, &hdr, sizeof(hdr), src, 64);
+    MsgQ_Get(mq, &hdr, sizeof(hdr), dst, 64); BENCH_KEEP(dst);
+}
+
+/* dhcp: render the typical offer options and parse them back */
+BENCH(dhcp_options_render_parse, 0)
+{
+    /* options that go into the offer */
+    dhcp_optset_t opts = {
+        .optflags = DHCP_OPTFLAGS_MSGTYPE | DHCP_OPTFLAGS_SUBNET |
+            DHCP_OPTFLAGS_ROUTER | DHCP_OPTFLAGS_DNS_SERVERS |
+            DHCP_OPTFLAGS_LEASE_TIME | DHCP_OPTFLAGS_DHCP_SERVER |
+            DHCP_OPTFLAGS_END,
+        .msg_type = DHCP_MSG_TYPE_OFFER,
+        .subnet = TCPIP_IP_ADDR(255, 255, 255, 0),
+        .router = TCPIP_IP_ADDR(192, 168, 1, 1),
+        .server = TCPIP_IP_ADDR(192, 168, 1, 1),
+        .dns = { TCPIP_IP_ADDR(192, 168, 1, 1) }, .dns_cnt = 1,
+        .lease_time = 3600,
+    }, parsed;
+    /* render into the buffer */
+    uint8_t *end = DHCPFrame_RenderOptions(dst, sizeof(dst), &opts);
+    /* parse it back */
+    if (end) {
+        const void *pend = DHCPFrame_ParseOptions(dst, end - dst, &parsed);
+        BENCH_KEEP(pend);
+    }
+}
+
+/* mdns: encode the host name and decode it back from the frame */
+BENCH(mdns_name_encode_decode, 0)
+{
+    /* frame header followed by the name */
+    mdns_frame_t *frame = (mdns_frame_t *)dst;
+    /* encode the name */
+    err_t ec = MDNSFrame_EncodeName("yield-stm32.local", frame->pld,
+        sizeof(dst) - sizeof(*frame));
+    /* decode it back */
+    if (ec > 0) {
+        ec = MDNSFrame_DecodeName(frame->pld, frame, sizeof(*frame) + ec,
+            text, sizeof(text));
+        BENCH_KEEP(ec);
+    }
+}
+
+/* uhttpsrv: parse the request line */
+BENCH(uhttpsrv_parse_request_line, 0)
+{
+    /* line under test */
+    static const char line[] = "GET /index.html HTTP/1.1";
+    /* parsed values */
+    enum uhttp_method method; enum uhttp_version version;
+    /* parse the line */
+    err_t ec = UHTTPSrv_ParseRequestLine(line, sizeof(line) - 1, &method,
+        text, sizeof(text), &version);
+    BENCH_KEEP(ec);
+}
+
+/* uhttpsrv: parse the header field line */
+BENCH(uhttpsrv_parse_field_line, 0)
+{
+    /* line under test */
+    static const char line[] = "Content-Length: 12345";
+    /* parsed field */
+    uhttp_field_t field;
+    /* parse the line */
+    err_t ec = UHTTPSrv_ParseFieldLine(line, sizeof(line) - 1, &field);
+    BENCH_KEEP(ec);
+}
@@ -11,6 +11,7 @@
 #include "sys/yield.h"
 #include "sys/sleep.h"
 #include "sys/ev.h"
+#include "util/elems.h"
 #include "util/forall.h"
 #include "compiler.h"
 
@@ -38,10 +39,15 @@ static void TestEV_Producer(void *arg)
 {
     /* value that we will broadcast */
     int value = 0;
+    /* notify does not wait for the listeners so the arguments must outlive
+     * the call: keep more of them than there are mailbox slots */
+    static evarg_t args[SYS_EV_LISTENER_QUEUE_SIZE + 1];
 
     for (;; Sleep(1000)) {
+        /* argument for this call */
+        evarg_t *a = &args[value % elems(args)];
         /* notify to all listeners */
-        Ev_Notify(&ev, &(evarg_t){.value = value});
+        a->value = value, Ev_Notify(&ev, a);
         dprintf_i("notified of %d\n", value);
         value++;
     }
@@ -61,7 +67,8 @@ static void TestEV_Listener(void *arg)
                 continue;
             }
 
-            dprintf_i("a = %d\n", a->value);
+            dprintf_i("a = %d, overruns = %d\n", a->value,
+                Ev_GetOverruns(l));
             if (a->value > 10)
                 break;
         }
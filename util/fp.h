@@ -30,10 +30,18 @@
 /* negaive infinity */
 #define fp_INFN                             (-INFINITY)
 
+/* use the fpu instructions on target, compiler builtins elsewhere (host) */
+#ifdef __arm__
 /** @brief square root */
 #define fp_sqrtf(x)							Arch_VSQRT(x)
 /** @brief absolute value */
 #define fp_fabsf(x)							Arch_VABS(x)
+#else
+/** @brief square root */
+#define fp_sqrtf(x)							__builtin_sqrtf(x)
+/** @brief absolute value */
+#define fp_fabsf(x)							__builtin_fabsf(x)
+#endif
 /** @brief power function */
 #define fp_powf(a, b)						pow(a, b)
 /** @brief cube root function */
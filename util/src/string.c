@@ -38,7 +38,7 @@ int OPTIMIZE("Os") memcmp(const void *ptr1, const void *ptr2, size_t num)
 }
 
 /* memory area copy */
-void * OPTIMIZE("03") memcpy(void * restrict dst, const void * restrict src, 
+void * HOT OPTIMIZE("03") memcpy(void * restrict dst, const void * restrict src, 
     size_t size)
 {
     /* pointers */
@@ -25,6 +25,7 @@
  #include "sys/yield.h"
  #include "util/elems.h"
 
+ #include "dev/prof.h"
  #include "dev/watchdog.h"
 
  /* shorthands so that the vector table looks neat! */
@@ -50,6 +51,8 @@
      /* interrupts */
      /* watchdog */
      SET_INT_VEC(STM32_INT_WWDG, Watchdog_WWDGIsr),
+     /* profiler sampling timer */
+     SET_INT_VEC(STM32_INT_TIM3, Prof_TIM3Isr),
  };
 
  /* initialize vector table */
@@ -12,7 +12,9 @@
 #include "err.h"
 
 /**
- * @brief create api serving server instance
+ * @brief create api serving server instance (port 6969). Endpoints:
+ * '/sysconf' - GET returns the system configuration in use, POST validates
+ * and persists the new one (see sysconf.h) which takes effect after the reset
  *
  * @return err_t error code
  */
@@ -11,6 +11,7 @@
 #include "dev/led.h"
 #include "ffs/ffs.h"
 #include "net/uhttpsrv/uhttpsrv.h"
+#include "sys/sysconf.h"
 #include "util/elems.h"
 #include "util/stdio.h"
 #include "util/string.h"
@@ -24,6 +25,9 @@ typedef struct endpoint_spec {
     const char *url;
     /* allowed methods */
     uhttp_method_t methods;
+    /* request processor (for all the methods but the options) */
+    uhttp_status_code_t (*process)(uhttp_request_t *req,
+        const struct endpoint_spec *es);
 } endpoint_spec_t;
 
 /* method specifiers */
@@ -58,23 +62,6 @@ static const method_spec_t * HTTPSrvApi_GetMethodSpec(
     return 0;
 }
 
-/* get the specification of supported api endpoints */
-static const endpoint_spec_t * HTTPSrvApi_GetEnpointSpec(const char *url)
-{
-    /* specification of supported endpoints */
-    static const endpoint_spec_t *l, lut[] = {
-        { "/", HTTP_METHOD_POST | HTTP_METHOD_OPTIONS },
-    };
-
-    /* look for spec for this endpoint */
-    for (l = lut; l != lut + elems(lut); l++)
-        if (strcmp(l->url, url) == 0)
-            return l;
-
-    /* nothing was found */
-    return 0;
-}
-
 /* process the post request */
 static uhttp_status_code_t HTTPSrvApi_ProcessPost(uhttp_request_t *req,
     const endpoint_spec_t *es)
@@ -106,6 +93,85 @@ static uhttp_status_code_t HTTPSrvApi_ProcessPost(uhttp_request_t *req,
     return EOK;
 }
 
+/* read (get) or persist (post) the system configuration. configuration is
+ * exchanged as decimal numbers separated with spaces in the order of the
+ * sysconf_t fields, stored configuration takes effect after the reset */
+static uhttp_status_code_t HTTPSrvApi_ProcessSysConf(uhttp_request_t *req,
+    const endpoint_spec_t *es)
+{
+    /* payload data */
+    char data[128]; int data_len;
+    /* configuration fields */
+    unsigned int v[7];
+
+    /* consume the fields if any */
+    for (uhttp_field_t f; req->state == HTTP_STATE_READ_FIELDS;
+        UHTTPSrv_ReadHeaderField(req, &f));
+
+    /* store the configuration */
+    if (req->method == HTTP_METHOD_POST) {
+        /* read the data */
+        if ((data_len = UHTTPSrv_ReadBody(req, data, sizeof(data))) < EOK)
+            return HTTP_STATUS_400_BAD_REQUEST;
+        /* parse all the fields */
+        if (snscanf(data, data_len, "%u %u %u %u %u %u %u", &v[0], &v[1],
+            &v[2], &v[3], &v[4], &v[5], &v[6]) != elems(v))
+            return HTTP_STATUS_400_BAD_REQUEST;
+
+        /* build up the configuration */
+        sysconf_t conf = {
+            .heap_size = v[0], .coro_stack_size = v[1], .coro_max_num = v[2],
+            .tcp_sock_num = v[3], .udp_sock_num = v[4],
+            .eem_rx_buf_num = v[5], .eem_tx_buf_num = v[6],
+        };
+        /* configuration that would not boot */
+        if (SysConf_Validate(&conf) != EOK)
+            return HTTP_STATUS_400_BAD_REQUEST;
+        /* unable to write the flash */
+        if (SysConf_Store(&conf) != EOK)
+            return HTTP_STATUS_500_INTERNAL_SRV_ERR;
+        /* all went well */
+        return HTTP_STATUS_200_OK;
+    }
+
+    /* render the configuration in use */
+    data_len = snprintf(data, sizeof(data), "%u %u %u %u %u %u %u\n",
+        (unsigned int)sysconf.heap_size, (unsigned int)sysconf.coro_stack_size,
+        (unsigned int)sysconf.coro_max_num, (unsigned int)sysconf.tcp_sock_num,
+        (unsigned int)sysconf.udp_sock_num,
+        (unsigned int)sysconf.eem_rx_buf_num,
+        (unsigned int)sysconf.eem_tx_buf_num);
+
+    /* respond with the status */
+    UHTTPSrv_SendStatus(req, HTTP_STATUS_200_OK, data_len);
+    UHTTPSrv_EndHeader(req);
+    /* send the data */
+    UHTTPSrc_SendBody(req, data, data_len);
+
+    /* response was already sent */
+    return HTTP_STATUS_UNKNOWN;
+}
+
+/* get the specification of supported api endpoints */
+static const endpoint_spec_t * HTTPSrvApi_GetEnpointSpec(const char *url)
+{
+    /* specification of supported endpoints */
+    static const endpoint_spec_t *l, lut[] = {
+        { "/", HTTP_METHOD_POST | HTTP_METHOD_OPTIONS,
+            HTTPSrvApi_ProcessPost },
+        { "/sysconf", HTTP_METHOD_GET | HTTP_METHOD_POST | HTTP_METHOD_OPTIONS,
+            HTTPSrvApi_ProcessSysConf },
+    };
+
+    /* look for spec for this endpoint */
+    for (l = lut; l != lut + elems(lut); l++)
+        if (strcmp(l->url, url) == 0)
+            return l;
+
+    /* nothing was found */
+    return 0;
+}
+
 /* handle options requests */
 static uhttp_status_code_t HTTPSrvApi_ProcessOptions(uhttp_request_t *req,
     const endpoint_spec_t *es)
@@ -169,11 +235,9 @@ static err_t HTTPSrvApi_ProcessRequest(uhttp_request_t *req)
     /* http options method, used annd abused by javascript 'axios' */
     case HTTP_METHOD_OPTIONS: 
         sc = HTTPSrvApi_ProcessOptions(req, es); break;
-    /* http post method */
-    case HTTP_METHOD_POST: 
-        sc = HTTPSrvApi_ProcessPost(req, es); break;
-    /* please add support for more methods */
-    default: return EFATAL;
+    /* all other methods are handled by the endpoint */
+    default:
+        sc = es->process(req, es); break;
     }
 
     /* if instead of the status code we are given the EOK then it means that 
@@ -208,9 +272,16 @@ err_t HTTPSrvApi_Init(void)
     static uhttp_instance_t instance = {
         .port = 6969,
         .timeout = 2000,
+        .max_connections = 1,
+        .stack_size = 2048,
         .callback = HTTPSrvApi_ProcessRequest
     };
 
     /* start the server */
-    return UHTTPSrv_InstanceInit(&instance);
+    err_t ec = UHTTPSrv_InstanceInit(&instance);
+    /* check if we can create the server task */
+    assert(ec >= EOK, "unable to create the api server task");
+
+    /* report the status code */
+    return ec;
 }
\ No newline at end of file
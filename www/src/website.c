@@ -12,6 +12,7 @@
 #include "util/string.h"
 #include "net/uhttpsrv/uhttpsrv.h"
 #include "net/uhttpsrv/ws.h"
+#include "sys/mutex.h"
 #include "util/string.h"
 #include "util/elems.h"
 
@@ -99,8 +100,8 @@ static err_t HTTPSrvWebsite_CallbackFiles(struct uhttp_request *req)
 
     /* buffer for transferrinng the file (we use one buffer for all instances) */
     static uint8_t fbuf[1024];
-    /* use this semaphore to guard the buffer */
-    static sem_t fbuf_sem = SEM_RELEASED;
+    /* use this mutex to guard the buffer (requests are served in order) */
+    static mutex_t fbuf_mutex = MUTEX_RELEASED;
     /* size of the data within the file */
     int fbuf_size;
 
@@ -127,7 +128,7 @@ static err_t HTTPSrvWebsite_CallbackFiles(struct uhttp_request *req)
     UHTTPSrv_SendHeaderField(req, HTTP_FIELD_NAME_CONNECTION, "close");
 
     /* we use one buffer for file reading to save ram */
-    with_sem (&fbuf_sem) {
+    with_mutex (&fbuf_mutex) {
         /* this is a naive way of telling if the file is gzipped. first we check
          * for the magic number 0x1f8b and then we check for the algorithm
          * (which is expected to be DEFLATE denoted by 0x08) */